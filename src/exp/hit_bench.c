@@ -0,0 +1,54 @@
+// Micro-benchmark of hit_test_rects against one CheckCollisionPointRec per rectangle.
+// Runs without a window:
+//   gcc hit_bench.c -DRUI_HEADLESS -O2 -o hit_bench -lm && ./hit_bench
+#include "../rui.h"
+#include <stdio.h>
+#include <time.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Top-most hit the way widgets test themselves today: one scalar check per rectangle
+static int hit_test_each(const Rectangle *rects, int count, Vector2 point) {
+    for (int i = count - 1; i >= 0; i--) {
+        if (CheckCollisionPointRec(point, rects[i])) return i;
+    }
+    return -1;
+}
+
+int main(void) {
+    int sizes[] = { 1000, 10000, 100000 };
+    enum { QUERIES = 256 };
+    Vector2 points[QUERIES];
+    srand(1);
+    for (int i = 0; i < QUERIES; i++) points[i] = (Vector2){ rand() % 4000, rand() % 4000 };
+
+    printf("%8s %14s %14s %8s\n", "rects", "scalar ns/q", "batch ns/q", "speedup");
+    for (int s = 0; s < 3; s++) {
+        int count = sizes[s];
+        Rectangle *aos = malloc(count * sizeof(Rectangle));
+        rui_rect_array soa = {0};
+        // Small rectangles over a 4000x4000 area, so most queries scan a large part of the array
+        for (int i = 0; i < count; i++) {
+            aos[i] = (Rectangle){ rand() % 4000, rand() % 4000, 4 + rand() % 16, 4 + rand() % 16 };
+            rect_array_add(&soa, aos[i]);
+        }
+
+        int repeats = 20000000 / count;
+        long checksum = 0;
+        double start = now();
+        for (int r = 0; r < repeats; r++) checksum += hit_test_each(aos, count, points[r % QUERIES]);
+        double scalar = (now() - start) / repeats;
+        start = now();
+        for (int r = 0; r < repeats; r++) checksum -= rect_array_hit(&soa, points[r % QUERIES]);
+        double batch = (now() - start) / repeats;
+
+        printf("%8d %14.1f %14.1f %7.1fx%s\n", count, scalar * 1e9, batch * 1e9, scalar / batch, checksum ? "  MISMATCH" : "");
+        free(aos);
+        free_rect_array(&soa);
+    }
+    return 0;
+}
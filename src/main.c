@@ -2,40 +2,62 @@
 
 int main() {
     init_ui("title", 800, 600);
+    set_frame_pacing(PACING_ON_DEMAND); // Sleep until input instead of spinning at 60 FPS
 
     MenuWindow menu = create_menu_window(100, 100, 400, 300, "Menu Window", WINDOW_MODE_RESIZABLE, true, true, true, 800);
+    set_menu_window_cached(&menu, true); // Dragging the window reuses its last rendering
+    MenuWindow panel = create_menu_window(450, 250, 250, 200, "Panel", WINDOW_MODE_RESIZABLE, true, true, false, 0);
 
     // Button
     Button mybutton = create_button("Click Me", 20, 20);
     TextBox mytextbox = create_text_box(40, 100, 300, 150, 14, COLOR_BLACK, COLOR_WHITE, "Enter your text here...");
     TextEntry entry = create_text_entry(20, 70, 300, 20, 14, COLOR_BLACK, COLOR_WHITE);
 
-    while (!WindowShouldClose()) {
+    // The window owns the widgets' positions; they follow it without per-frame bookkeeping
+    int button_node = add_child_button(&menu, MENU_WINDOW_ROOT, &mybutton);
+    int textbox_node = add_child_text_box(&menu, MENU_WINDOW_ROOT, &mytextbox);
+    int entry_node = add_child_text_entry(&menu, MENU_WINDOW_ROOT, &entry);
+    Button panel_button = create_button("Reset", 20, 50);
+    int panel_button_node = add_child_button(&panel, MENU_WINDOW_ROOT, &panel_button);
+
+    // Clicks go to the top-most window, which comes to the front
+    rui_window_manager windows = create_window_manager();
+    add_managed_window(&windows, &menu);
+    add_managed_window(&windows, &panel);
+
+    // Only the focused text widget sees the keyboard; Tab moves between them
+    rui_context ui = create_context();
+    add_focus_child(&ui, &menu, entry_node);
+    add_focus_child(&ui, &menu, textbox_node);
+
+    while (!ui_should_close()) {
         // Updates
-        update_menu_window(&menu);
-        update_button_position(&mybutton, &menu); // working
-        update_text_box(&mytextbox);
-		update_textbox_position(&mytextbox, &menu); // working
-        update_text_entry(&entry);
-		update_entry_position(&entry,&menu);
-        if (update_button(&mybutton)) {
+        rui_input input = poll_input();
+        update_window_manager(&windows, &input);
+        update_focus(&ui, &input);
+        if (managed_window_clicked(&windows, &menu) == button_node) {
             // Button was clicked, handle the event
             TraceLog(LOG_INFO, "Button was clicked!");
         }
+        if (managed_window_clicked(&windows, &panel) == panel_button_node) {
+            TraceLog(LOG_INFO, "Reset was clicked!");
+        }
 
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
+        begin_drawing();
+        clear_background(COLOR_RAYWHITE);
 
-        // Render Menu and Button
-        render_menu_window(&menu);
-        render_button(&mybutton);
-		render_text_box(&mytextbox);
-		render_text_entry(&entry);
+        // Render the windows and their widgets, back to front
+        render_window_manager(&windows);
 
 
-        EndDrawing();
+        end_drawing();
     }
 
+    destroy_context(&ui);
+    destroy_menu_window(&menu);
+    destroy_menu_window(&panel);
+    destroy_text_box(&mytextbox);
+    destroy_text_entry(&entry);
     quit_ui();
     return 0;
 }
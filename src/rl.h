@@ -1,4 +1,12 @@
+// Backend: raylib by default, or the CPU rasterizer in rl_headless.h with -DRUI_HEADLESS
+#ifdef RUI_HEADLESS
+#include "rl_headless.h"
+#else
 #include "raylib.h"
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 typedef struct {
     uint8_t r;
     uint8_t g;
@@ -15,6 +23,8 @@ const RUI_COLOR COLOR_SKYBLUE = { 102, 191, 255, 255 }; // Raylib SKYBLUE
 const RUI_COLOR COLOR_DARKBLUE = { 0, 82, 172, 255 };   // Raylib DARKBLUE
 const RUI_COLOR COLOR_DARKGRAY = {80, 80, 80, 255};
 const RUI_COLOR COLOR_LIGHTGRAY = { 200, 200, 200, 255 };
+const RUI_COLOR COLOR_GRAY = { 130, 130, 130, 255 };    // Raylib GRAY
+const RUI_COLOR COLOR_RAYWHITE = { 245, 245, 245, 255 }; // Raylib RAYWHITE
 
 
 
@@ -29,40 +39,1360 @@ Color toRaylibColor(RUI_COLOR color) {
     return raylibColor;
 }
 
+//--------------------------- Draw command buffer ---------------------------
+// The draw_* wrappers below do not call raylib directly. They append to a
+// per-frame command buffer which end_drawing() sorts and submits, so commands
+// sharing the same scissor/texture/primitive state go out as one batch.
+
+// Kind of primitive a command draws
+typedef enum {
+    RL_CMD_RECT,
+    RL_CMD_RECT_ROUNDED,
+    RL_CMD_RECT_LINES,
+    RL_CMD_CIRCLE,
+    RL_CMD_TEXT,
+    RL_CMD_CLEAR,
+    RL_CMD_SURFACE
+} RL_CMD_TYPE;
+
+// GPU state a command needs; rlgl flushes its batch whenever this changes
+typedef enum {
+    RL_BATCH_SHAPES,   // Triangles/quads with the shapes texture
+    RL_BATCH_LINES,    // Line primitives
+    RL_BATCH_TEXT,     // Quads with the font texture
+    RL_BATCH_SURFACE   // Quads with a cached surface's texture
+} RL_BATCH_TYPE;
+
+#define RL_CMD_TILE 16         // cell size in pixels of the grid used to find overlapping commands
+#define RL_MAX_SCISSORS 256    // distinct scissor rects per frame
+#define RL_MAX_SCISSOR_DEPTH 16 // nested begin_scissor() calls
+#define RL_MAX_SURFACES 64     // cached surfaces alive at the same time
+
+typedef struct {
+    uint8_t type;          // RL_CMD_TYPE
+    uint8_t batch;         // RL_BATCH_TYPE
+    uint16_t scissor;      // index into the frame's scissor table, 0 = no scissor
+    uint32_t layer;        // painter's layer; sorting never moves a command across layers
+    uint32_t seq;          // submission order, used as the final tie-breaker
+    float x, y, w, h;      // geometry (circle: x,y = center, w = radius)
+    float roundness;       // rounded rectangles only
+    int segments;          // rounded rectangles only
+    int font_size;         // text only
+    uint32_t text;         // text only: offset into the frame's text storage
+    int surface;           // surfaces only: index into the surface table
+    RUI_COLOR color;
+    Rectangle bounds;      // screen-space area the command touches
+} rl_draw_cmd;
+
+// Counters for the last submitted frame
+typedef struct {
+    int commands;          // commands recorded
+    int batches;           // state changes after sorting (≈ draw calls)
+    int unsorted_batches;  // state changes the submission order would have caused
+    int scissor_changes;   // BeginScissorMode/EndScissorMode transitions
+    int damage_regions;    // damaged rectangles redrawn, 0 when the frame was skipped
+    int surfaces_redrawn;  // cached surfaces whose contents were redrawn
+    int surfaces_scrolled; // cached surfaces whose pixels were shifted by scroll_surface()
+    int culled;            // draw_* calls dropped for lying entirely outside the clip
+    bool presented;        // false when nothing was damaged and the frame was not drawn
+    double begin_time;     // GetTime() at begin_drawing()
+    double draw_seconds;   // from begin_drawing() until the frame was drawn, not counting presentation or waits
+} rl_draw_stats;
+
+static rl_draw_cmd *rl_cmds = NULL;
+static int rl_cmd_count = 0;
+static int rl_cmd_capacity = 0;
+static char *rl_cmd_text = NULL;           // text copied out of the caller's (possibly transient) buffers
+static uint32_t rl_cmd_text_size = 0;
+static uint32_t rl_cmd_text_capacity = 0;
+static Rectangle rl_scissors[RL_MAX_SCISSORS];
+static int rl_scissor_count = 1;           // slot 0 means "no scissor"
+static int rl_scissor_current = 0;
+static int rl_scissor_stack[RL_MAX_SCISSOR_DEPTH];  // enclosing scissors of rl_scissor_current
+static int rl_scissor_depth = 0;
+static rl_draw_stats rl_stats = {0};
+
+// Offscreen copy of a group of widgets, see "Cached surfaces" below
+typedef struct {
+    bool loaded;
+    RenderTexture2D target;  // may be larger than bounds; the contents start at its top-left corner
+    Rectangle bounds;        // screen area the surface is composited at
+    Rectangle damage;        // part of the contents to redraw, relative to bounds
+    bool valid;              // false until the contents have been drawn once
+    RenderTexture2D scratch; // what a scroll is copied into; then it becomes the target
+    Rectangle shift_area;    // part of the contents scroll_surface() moves, relative to bounds
+    Rectangle exposed;       // what scrolled into view, kept apart from damage so redrawing a scroll bar does not widen it
+    Vector2 shift;           // pending scroll, applied before the contents are next drawn
+} rl_surface;
+
+static rl_surface rl_surfaces[RL_MAX_SURFACES];
+static int rl_surface_current = -1;         // surface being recorded, -1 = the screen
+static Vector2 rl_cmd_origin = { 0, 0 };    // subtracted from every recorded coordinate
+static Vector2 rl_translation = { 0, 0 };   // added to every coordinate, see begin_translate()
+static uint32_t rl_cmd_floor = 0;           // lowest layer a new command may use
+static uint32_t rl_cmd_top_layer = 0;       // highest layer used so far
+
+// Grow the command arrays; capacity is kept between frames so steady state does not allocate
+static rl_draw_cmd *rl_cmd_push(void) {
+    if (rl_cmd_count == rl_cmd_capacity) {
+        int capacity = rl_cmd_capacity ? rl_cmd_capacity * 2 : 256;
+        rl_cmds = realloc(rl_cmds, capacity * sizeof(rl_draw_cmd));
+        rl_cmd_capacity = capacity;
+    }
+    rl_draw_cmd *cmd = &rl_cmds[rl_cmd_count];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->seq = rl_cmd_count++;
+    cmd->scissor = rl_scissor_current;
+    return cmd;
+}
+
+static uint32_t rl_cmd_store_text(const char *text, uint32_t length) {
+    uint32_t len = length + 1;
+    if (rl_cmd_text_size + len > rl_cmd_text_capacity) {
+        uint32_t capacity = rl_cmd_text_capacity ? rl_cmd_text_capacity : 4096;
+        while (rl_cmd_text_size + len > capacity) capacity *= 2;
+        rl_cmd_text = realloc(rl_cmd_text, capacity);
+        rl_cmd_text_capacity = capacity;
+    }
+    uint32_t offset = rl_cmd_text_size;
+    memcpy(rl_cmd_text + offset, text, length);
+    rl_cmd_text[offset + length] = '\0';
+    rl_cmd_text_size += len;
+    return offset;
+}
+
+static bool rl_rects_overlap(Rectangle a, Rectangle b) {
+    if (a.width <= 0 || a.height <= 0 || b.width <= 0 || b.height <= 0) return false;
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+           a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static Rectangle rl_rect_union(Rectangle a, Rectangle b) {
+    if (a.width <= 0 || a.height <= 0) return b;
+    if (b.width <= 0 || b.height <= 0) return a;
+    float x0 = a.x < b.x ? a.x : b.x;
+    float y0 = a.y < b.y ? a.y : b.y;
+    float x1 = (a.x + a.width > b.x + b.width) ? a.x + a.width : b.x + b.width;
+    float y1 = (a.y + a.height > b.y + b.height) ? a.y + a.height : b.y + b.height;
+    return (Rectangle){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+// Overlap of two rectangles; empty (all zero) when they do not overlap
+Rectangle rect_intersect(Rectangle a, Rectangle b) {
+    float x0 = a.x > b.x ? a.x : b.x;
+    float y0 = a.y > b.y ? a.y : b.y;
+    float x1 = (a.x + a.width < b.x + b.width) ? a.x + a.width : b.x + b.width;
+    float y1 = (a.y + a.height < b.y + b.height) ? a.y + a.height : b.y + b.height;
+    if (x1 <= x0 || y1 <= y0) return (Rectangle){ 0, 0, 0, 0 };
+    return (Rectangle){ x0, y0, x1 - x0, y1 - y0 };
+}
+
+// Sort key: scissor first, then GPU batch state
+static uint32_t rl_cmd_key(const rl_draw_cmd *cmd) {
+    return ((uint32_t)cmd->scissor << 8) | cmd->batch;
+}
+
+// Highest layers drawn so far in one RL_CMD_TILE sized screen cell. Layers are
+// stored +1 so 0 means "nothing here yet"; `other` is the highest layer among
+// commands whose key differs from `top_key` (possibly over-estimated).
+typedef struct {
+    uint32_t frame;
+    uint32_t top;
+    uint32_t top_key;
+    uint32_t other;
+} rl_cmd_tile;
+
+static rl_cmd_tile *rl_cmd_tiles = NULL;
+static int rl_cmd_tiles_x = 0;
+static int rl_cmd_tiles_y = 0;
+static uint32_t rl_cmd_frame = 0;
+
+static void rl_cmd_tile_range(Rectangle r, int *x0, int *y0, int *x1, int *y1) {
+    // Off-screen parts clamp to the border cells, which only makes the test more conservative
+    *x0 = (int)r.x / RL_CMD_TILE;
+    *y0 = (int)r.y / RL_CMD_TILE;
+    *x1 = (int)(r.x + r.width) / RL_CMD_TILE;
+    *y1 = (int)(r.y + r.height) / RL_CMD_TILE;
+    if (*x0 < 0) *x0 = 0;
+    if (*y0 < 0) *y0 = 0;
+    if (*x1 >= rl_cmd_tiles_x) *x1 = rl_cmd_tiles_x - 1;
+    if (*y1 >= rl_cmd_tiles_y) *y1 = rl_cmd_tiles_y - 1;
+    if (*x0 > *x1) *x0 = *x1;
+    if (*y0 > *y1) *y0 = *y1;
+}
+
+// Place the newest command in the lowest layer that keeps it above every
+// earlier command with different state sharing a tile with it. Within one
+// layer, commands of different state never overlap, so grouping them by
+// state cannot change what ends up on screen.
+static void rl_cmd_assign_layer(rl_draw_cmd *cmd) {
+    uint32_t key = rl_cmd_key(cmd);
+    uint32_t layer = rl_cmd_floor;
+    if (rl_cmd_tiles == NULL) {
+        cmd->layer = cmd->seq;  // recorded outside begin_drawing(): keep submission order
+        return;
+    }
+    if (cmd->bounds.width <= 0 || cmd->bounds.height <= 0) {
+        cmd->layer = rl_cmd_floor;  // nothing visible, nothing to order against
+        return;
+    }
+    int x0, y0, x1, y1;
+    rl_cmd_tile_range(cmd->bounds, &x0, &y0, &x1, &y1);
+    for (int ty = y0; ty <= y1; ty++) {
+        for (int tx = x0; tx <= x1; tx++) {
+            rl_cmd_tile *tile = &rl_cmd_tiles[ty * rl_cmd_tiles_x + tx];
+            if (tile->frame != rl_cmd_frame || tile->top == 0) continue;
+            uint32_t needed = (tile->top_key == key) ? tile->top - 1 : tile->top;
+            if (tile->top_key == key && tile->other > needed) needed = tile->other;
+            if (needed > layer) layer = needed;
+        }
+    }
+    cmd->layer = layer;
+    if (layer > rl_cmd_top_layer) rl_cmd_top_layer = layer;
+    uint32_t stored = layer + 1;
+    for (int ty = y0; ty <= y1; ty++) {
+        for (int tx = x0; tx <= x1; tx++) {
+            rl_cmd_tile *tile = &rl_cmd_tiles[ty * rl_cmd_tiles_x + tx];
+            if (tile->frame != rl_cmd_frame) *tile = (rl_cmd_tile){ rl_cmd_frame, 0, 0, 0 };
+            if (tile->top == 0 || tile->top_key == key) {
+                if (stored > tile->top) tile->top = stored;
+                tile->top_key = key;
+            } else if (stored > tile->top) {
+                tile->other = tile->top;
+                tile->top = stored;
+                tile->top_key = key;
+            } else if (stored > tile->other) {
+                tile->other = stored;
+            }
+        }
+    }
+}
+
+static void rl_cmd_finish(rl_draw_cmd *cmd) {
+    // Inside a surface, coordinates are relative to its top-left corner
+    cmd->x += rl_translation.x - rl_cmd_origin.x;
+    cmd->y += rl_translation.y - rl_cmd_origin.y;
+    cmd->bounds.x += rl_translation.x - rl_cmd_origin.x;
+    cmd->bounds.y += rl_translation.y - rl_cmd_origin.y;
+    if (cmd->scissor) {
+        // Only the visible part of a clipped command can overlap anything
+        cmd->bounds = rect_intersect(cmd->bounds, rl_scissors[cmd->scissor]);
+    }
+    rl_cmd_assign_layer(cmd);
+}
+
+static int rl_cmd_compare(const void *a, const void *b) {
+    const rl_draw_cmd *ca = a;
+    const rl_draw_cmd *cb = b;
+    if (ca->layer != cb->layer) return ca->layer < cb->layer ? -1 : 1;
+    uint32_t ka = rl_cmd_key(ca), kb = rl_cmd_key(cb);
+    if (ka != kb) return ka < kb ? -1 : 1;
+    return ca->seq < cb->seq ? -1 : (ca->seq > cb->seq);
+}
+
+static void rl_cmd_execute(const rl_draw_cmd *cmd) {
+    Color color = toRaylibColor(cmd->color);
+    switch (cmd->type) {
+        case RL_CMD_RECT:
+            DrawRectangleRec((Rectangle){ cmd->x, cmd->y, cmd->w, cmd->h }, color);
+            break;
+        case RL_CMD_RECT_ROUNDED:
+            DrawRectangleRounded((Rectangle){ cmd->x, cmd->y, cmd->w, cmd->h }, cmd->roundness, cmd->segments, color);
+            break;
+        case RL_CMD_RECT_LINES:
+            DrawRectangleLines(cmd->x, cmd->y, cmd->w, cmd->h, color);
+            break;
+        case RL_CMD_CIRCLE:
+            DrawCircle(cmd->x, cmd->y, cmd->w, color);
+            break;
+        case RL_CMD_TEXT:
+            DrawText(rl_cmd_text + cmd->text, cmd->x, cmd->y, cmd->font_size, color);
+            break;
+        case RL_CMD_CLEAR:
+            ClearBackground(color);  // limited to the damaged region by the scissor
+            break;
+        case RL_CMD_SURFACE: {
+            // Render textures are stored bottom-up, so the contents are the last rows, flipped
+            Texture2D texture = rl_surfaces[cmd->surface].target.texture;
+            Rectangle source = { 0, texture.height - cmd->h, cmd->w, -cmd->h };
+            DrawTextureRec(texture, source, (Vector2){ cmd->x, cmd->y }, color);
+            break;
+        }
+    }
+}
+
+//--------------------------- Damage tracking ---------------------------
+// Widgets report the screen areas whose pixels change from their update_*
+// functions. Only those areas are redrawn, and a frame with no damage is
+// not drawn or presented at all. Code that changes what is on screen
+// behind the widgets' back (e.g. editing a label) must call damage_rect().
+
+#define RL_MAX_DAMAGE 16       // separate damaged rectangles before they are merged
+
+static Rectangle rl_damage[RL_MAX_DAMAGE];
+static int rl_damage_count = 0;
+static bool rl_damage_everything = true;  // first frame, resize, or damage_screen()
+
+static float rl_rect_area(Rectangle r) {
+    return r.width * r.height;
+}
+
+static void rl_damage_add(Rectangle rect) {
+    if (rl_damage_everything || rect.width <= 0 || rect.height <= 0) return;
+    // Absorb every rectangle it touches so the list stays disjoint
+    for (int i = 0; i < rl_damage_count; i++) {
+        Rectangle touching = { rect.x - 1, rect.y - 1, rect.width + 2, rect.height + 2 };
+        if (rl_rects_overlap(touching, rl_damage[i])) {
+            rect = rl_rect_union(rect, rl_damage[i]);
+            rl_damage[i] = rl_damage[--rl_damage_count];
+            i = -1;
+        }
+    }
+    if (rl_damage_count == RL_MAX_DAMAGE) {
+        // Merge into the rectangle that grows the least
+        int best = 0;
+        float best_growth = 0;
+        for (int i = 0; i < rl_damage_count; i++) {
+            float growth = rl_rect_area(rl_rect_union(rect, rl_damage[i])) - rl_rect_area(rl_damage[i]);
+            if (i == 0 || growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        rect = rl_rect_union(rect, rl_damage[best]);
+        rl_damage[best] = rl_damage[--rl_damage_count];
+        rl_damage_add(rect);
+        return;
+    }
+    rl_damage[rl_damage_count++] = rect;
+}
+
+// Mark an area of the screen as needing a redraw
+void damage_rect(Rectangle rect) {
+    rect.x += rl_translation.x;
+    rect.y += rl_translation.y;
+    // The contents of cached surfaces under the area changed as well
+    for (int i = 0; i < RL_MAX_SURFACES; i++) {
+        rl_surface *surface = &rl_surfaces[i];
+        if (!surface->loaded || !rl_rects_overlap(rect, surface->bounds)) continue;
+        Rectangle local = rect_intersect(rect, surface->bounds);
+        local.x -= surface->bounds.x;
+        local.y -= surface->bounds.y;
+        surface->damage = rl_rect_union(surface->damage, local);
+    }
+    rl_damage_add(rect);
+}
+
+// Mark an area of the screen as needing a redraw while the contents of the
+// cached surfaces under it stay valid, e.g. when only their stacking changed
+void recomposite_rect(Rectangle rect) {
+    rect.x += rl_translation.x;
+    rect.y += rl_translation.y;
+    rl_damage_add(rect);
+}
+
+// Redraw the whole screen on the next frame
+void damage_screen() {
+    rl_damage_everything = true;
+    rl_damage_count = 0;
+}
+
+// True when the current scissor hides all of `rect`, given in draw_* coordinates
+static bool rl_outside_clip(Rectangle rect) {
+    if (!rl_scissor_current) return false;
+    rect.x += rl_translation.x - rl_cmd_origin.x;
+    rect.y += rl_translation.y - rl_cmd_origin.y;
+    return !rl_rects_overlap(rect, rl_scissors[rl_scissor_current]);
+}
+
+// True if any part of `rect` will be redrawn this frame; render_* functions skip recording otherwise
+bool is_damaged(Rectangle rect) {
+    if (rl_outside_clip(rect)) return false;  // nothing is drawn there
+    rect.x += rl_translation.x;
+    rect.y += rl_translation.y;
+    if (rl_surface_current >= 0) {
+        rect.x -= rl_cmd_origin.x;
+        rect.y -= rl_cmd_origin.y;
+        return rl_rects_overlap(rect, rl_surfaces[rl_surface_current].damage) ||
+               rl_rects_overlap(rect, rl_surfaces[rl_surface_current].exposed);
+    }
+    if (rl_damage_everything) return true;
+    for (int i = 0; i < rl_damage_count; i++) {
+        if (rl_rects_overlap(rect, rl_damage[i])) return true;
+    }
+    return false;
+}
+
+bool has_damage() {
+    return rl_damage_everything || rl_damage_count > 0;
+}
+
+static void rl_set_scissor(Rectangle *current, Rectangle clip) {
+    if (current->x == clip.x && current->y == clip.y && current->width == clip.width && current->height == clip.height) return;
+    if (current->width > 0) EndScissorMode();
+    if (clip.width > 0) BeginScissorMode(clip.x, clip.y, clip.width, clip.height);
+    *current = clip;
+    rl_stats.scissor_changes++;
+}
+
+// Draw the sorted commands that touch `region`, clipped to it. `clip` tracks the scissor in effect.
+static void rl_cmd_draw_region(const rl_draw_cmd *cmds, int count, Rectangle region, bool whole_target, Rectangle *clip) {
+    uint32_t key = UINT32_MAX;
+    for (int i = 0; i < count; i++) {
+        const rl_draw_cmd *cmd = &cmds[i];
+        if (!rl_rects_overlap(cmd->bounds, region)) continue;
+        Rectangle wanted = cmd->scissor ? rect_intersect(rl_scissors[cmd->scissor], region) : region;
+        if (whole_target && !cmd->scissor) wanted = (Rectangle){ 0, 0, 0, 0 };
+        rl_set_scissor(clip, wanted);
+        if (rl_cmd_key(cmd) != key) {
+            key = rl_cmd_key(cmd);
+            rl_stats.batches++;
+        }
+        rl_cmd_execute(cmd);
+    }
+}
+
+// Sort the frame's commands and redraw the damaged regions with them
+static void rl_cmd_flush(void) {
+    rl_stats.commands = rl_cmd_count;
+    for (int i = 1; i < rl_cmd_count; i++) {
+        if (rl_cmd_key(&rl_cmds[i]) != rl_cmd_key(&rl_cmds[i - 1])) rl_stats.unsorted_batches++;
+    }
+    if (rl_cmd_count > 0) rl_stats.unsorted_batches++;
+
+    qsort(rl_cmds, rl_cmd_count, sizeof(rl_draw_cmd), rl_cmd_compare);
+
+    Rectangle screen = { 0, 0, GetScreenWidth(), GetScreenHeight() };
+    int regions = rl_damage_everything ? 1 : rl_damage_count;
+    rl_stats.damage_regions = regions;
+    Rectangle clip = { 0, 0, 0, 0 };
+    for (int r = 0; r < regions; r++) {
+        Rectangle region = rl_damage_everything ? screen : rect_intersect(rl_damage[r], screen);
+        rl_cmd_draw_region(rl_cmds, rl_cmd_count, region, rl_damage_everything, &clip);
+    }
+    rl_set_scissor(&clip, (Rectangle){ 0, 0, 0, 0 });
+}
+
+// Statistics of the last frame, complete once end_drawing() has returned
+rl_draw_stats get_draw_stats() {
+    return rl_stats;
+}
+
+// Commands of the current frame (submission order until end_drawing(), sorted afterwards)
+const rl_draw_cmd *get_draw_commands(int *count) {
+    *count = rl_cmd_count;
+    return rl_cmds;
+}
+
+// Text of a recorded RL_CMD_TEXT command
+const char *get_draw_command_text(const rl_draw_cmd *cmd) {
+    return rl_cmd_text + cmd->text;
+}
+
+//--------------------------- Draw wrappers ---------------------------
+// A call whose bounds lie entirely outside the current clip is dropped here,
+// before anything is recorded, so scrolled-out content costs nothing further.
+
+static bool rl_cull(Rectangle bounds) {
+    if (!rl_outside_clip(bounds)) return false;
+    rl_stats.culled++;
+    return true;
+}
+
 void draw_circle(int x, int y, float r, RUI_COLOR color){
-	Color raylibColor = toRaylibColor(color);
-	DrawCircle(x, y, r,raylibColor );
+	if (rl_cull((Rectangle){ x - r, y - r, 2 * r, 2 * r })) return;
+	rl_draw_cmd *cmd = rl_cmd_push();
+	cmd->type = RL_CMD_CIRCLE;
+	cmd->batch = RL_BATCH_SHAPES;
+	cmd->x = x;
+	cmd->y = y;
+	cmd->w = r;
+	cmd->color = color;
+	cmd->bounds = (Rectangle){ x - r, y - r, 2 * r, 2 * r };
+	rl_cmd_finish(cmd);
 }
 void draw_rectangle_from_rect(Rectangle rect, RUI_COLOR color){
-	Color raylibColor = toRaylibColor(color);
-    DrawRectangleRec(rect, raylibColor); 
+	if (rl_cull(rect)) return;
+	rl_draw_cmd *cmd = rl_cmd_push();
+	cmd->type = RL_CMD_RECT;
+	cmd->batch = RL_BATCH_SHAPES;
+	cmd->x = rect.x;
+	cmd->y = rect.y;
+	cmd->w = rect.width;
+	cmd->h = rect.height;
+	cmd->color = color;
+	cmd->bounds = rect;
+	rl_cmd_finish(cmd);
 }
 void draw_rectangle_lines(int x, int y, int width, int height, RUI_COLOR color) {
-    Color raylibColor = toRaylibColor(color);
-    DrawRectangleLines(x, y, width, height, raylibColor);
+    if (rl_cull((Rectangle){ x, y, width, height })) return;
+    rl_draw_cmd *cmd = rl_cmd_push();
+    cmd->type = RL_CMD_RECT_LINES;
+    cmd->batch = RL_BATCH_LINES;
+    cmd->x = x;
+    cmd->y = y;
+    cmd->w = width;
+    cmd->h = height;
+    cmd->color = color;
+    cmd->bounds = (Rectangle){ x, y, width, height };
+    rl_cmd_finish(cmd);
 }
 
-void draw_text(char * text,int  x,int  y, int font_size, RUI_COLOR color){
-	Color raylibColor = toRaylibColor(color);  // Convert color
-	DrawText(text, x, y, font_size, raylibColor); 
+// Function to draw the first `length` bytes of a string
+void draw_text_n(const char * text, int length, int x, int y, int font_size, RUI_COLOR color){
+	// No glyph is wider than its font size, so this over-estimates the text box
+	Rectangle bounds = { x, y, (float)length * font_size, font_size };
+	if (rl_cull(bounds)) return;
+	rl_draw_cmd *cmd = rl_cmd_push();
+	cmd->type = RL_CMD_TEXT;
+	cmd->batch = RL_BATCH_TEXT;
+	cmd->x = x;
+	cmd->y = y;
+	cmd->font_size = font_size;
+	cmd->text = rl_cmd_store_text(text, length);
+	cmd->color = color;
+	cmd->bounds = bounds;
+	rl_cmd_finish(cmd);
+}
+void draw_text(const char * text,int  x,int  y, int font_size, RUI_COLOR color){
+	draw_text_n(text, strlen(text), x, y, font_size, color);
 }
 // Function to draw a rectangle with text and custom color
 void draw_rectangle(int x, int y, int w, int h, RUI_COLOR color) {
-    Color raylibColor = toRaylibColor(color);  // Convert color
-    DrawRectangle(x, y, w, h, raylibColor);  // Draw rectangle
+    draw_rectangle_from_rect((Rectangle){ x, y, w, h }, color);
 }
 void draw_rectangle_rounded(Rectangle rect,float roundness , int seg, RUI_COLOR color) {
-	Color raylibColor = toRaylibColor(color);
-    DrawRectangleRounded(rect, 0.2f, 10, raylibColor);
+	if (rl_cull(rect)) return;
+	rl_draw_cmd *cmd = rl_cmd_push();
+	cmd->type = RL_CMD_RECT_ROUNDED;
+	cmd->batch = RL_BATCH_SHAPES;
+	cmd->x = rect.x;
+	cmd->y = rect.y;
+	cmd->w = rect.width;
+	cmd->h = rect.height;
+	cmd->roundness = roundness;
+	cmd->segments = seg;
+	cmd->color = color;
+	cmd->bounds = rect;
+	rl_cmd_finish(cmd);
+}
+
+// Clip the following draw_* calls to a rectangle until the matching
+// end_scissor(). Nested calls clip to the intersection with the enclosing ones.
+void begin_scissor(int x, int y, int w, int h) {
+    if (rl_scissor_depth == RL_MAX_SCISSOR_DEPTH) {
+        TraceLog(LOG_WARNING, "RUI: scissors nested too deep, clipping ignored");
+        rl_scissor_depth++;  // still balanced by end_scissor()
+        return;
+    }
+    rl_scissor_stack[rl_scissor_depth++] = rl_scissor_current;
+    if (rl_scissor_count == RL_MAX_SCISSORS) {
+        TraceLog(LOG_WARNING, "RUI: scissor table full, clipping ignored");
+        return;
+    }
+    Rectangle clip = { x + rl_translation.x - rl_cmd_origin.x, y + rl_translation.y - rl_cmd_origin.y, w, h };
+    if (rl_scissor_current) clip = rect_intersect(clip, rl_scissors[rl_scissor_current]);
+    rl_scissors[rl_scissor_count] = clip;  // an empty clip culls everything inside it
+    rl_scissor_current = rl_scissor_count++;
+}
+
+void end_scissor() {
+    if (rl_scissor_depth == 0) return;
+    rl_scissor_depth--;
+    if (rl_scissor_depth < RL_MAX_SCISSOR_DEPTH) rl_scissor_current = rl_scissor_stack[rl_scissor_depth];
+}
+
+#define RL_MAX_TRANSLATIONS 8
+
+static Vector2 rl_translations[RL_MAX_TRANSLATIONS];
+static int rl_translation_depth = 0;
+
+// Offset the following draw_*, damage_rect, is_damaged and begin_scissor calls
+// by (x, y), on top of the offset in effect, until end_translate(). Widgets
+// placed relative to a parent are drawn this way with the parent's position.
+void begin_translate(float x, float y) {
+    // Past the limit the offset is still applied; end_translate() takes it off again
+    if (rl_translation_depth < RL_MAX_TRANSLATIONS) rl_translations[rl_translation_depth] = rl_translation;
+    else if (rl_translation_depth == RL_MAX_TRANSLATIONS) TraceLog(LOG_WARNING, "RUI: translations nested too deep");
+    rl_translation_depth++;
+    rl_translation.x += x;
+    rl_translation.y += y;
+}
+
+void end_translate() {
+    if (rl_translation_depth == 0) return;
+    rl_translation_depth--;
+    if (rl_translation_depth < RL_MAX_TRANSLATIONS) rl_translation = rl_translations[rl_translation_depth];
+}
+
+//--------------------------- Cached surfaces ---------------------------
+// A surface is an offscreen copy of a group of widgets, e.g. a window and its
+// children. Between begin_surface() and end_surface() the draw_* calls go to
+// the surface, with its top-left corner as the origin, and the screen only
+// gets one textured quad. damage_rect() over the surface marks that part of
+// its contents for a redraw, while move_surface() only damages the screen, so
+// dragging a surface around redraws nothing but the quad. Surfaces are
+// recorded between begin_drawing() and end_drawing() and do not nest.
+
+#define RL_SURFACE_ALIGN 64    // texture sizes are rounded up so growing a surface rarely reallocates
+
+static int rl_surface_first = 0;           // first command of the surface being recorded
+static int rl_surface_scissor = 0;         // screen scissor to restore in end_surface()
+static uint32_t rl_surface_top_layer = 0;  // highest screen layer before begin_surface()
+
+// Create a surface; returns its id, or -1 when all RL_MAX_SURFACES are in use
+int load_surface() {
+    for (int i = 0; i < RL_MAX_SURFACES; i++) {
+        if (!rl_surfaces[i].loaded) {
+            rl_surfaces[i] = (rl_surface){0};
+            rl_surfaces[i].loaded = true;
+            return i;
+        }
+    }
+    TraceLog(LOG_WARNING, "RUI: surface table full, drawing without a cache");
+    return -1;
+}
+
+// Free a surface; the caller damages the area it covered if something else is drawn there now
+void unload_surface(int surface) {
+    if (surface < 0 || !rl_surfaces[surface].loaded) return;
+    if (rl_surfaces[surface].target.id != 0) UnloadRenderTexture(rl_surfaces[surface].target);
+    if (rl_surfaces[surface].scratch.id != 0) UnloadRenderTexture(rl_surfaces[surface].scratch);
+    rl_surfaces[surface] = (rl_surface){0};
+}
+
+// Place a surface on the screen. Resizing invalidates its contents, moving only recomposites them.
+void move_surface(int surface, Rectangle bounds) {
+    rl_surface *s = &rl_surfaces[surface];
+    if (s->bounds.x == bounds.x && s->bounds.y == bounds.y &&
+        s->bounds.width == bounds.width && s->bounds.height == bounds.height) return;
+    if (s->bounds.width != bounds.width || s->bounds.height != bounds.height) s->valid = false;
+    rl_damage_add(s->bounds);
+    rl_damage_add(bounds);
+    s->bounds = bounds;
+}
+
+// Send the following draw_* calls to a surface. Returns false when its contents
+// are up to date and need not be drawn; end_surface() must be called either way.
+bool begin_surface(int surface) {
+    rl_surface *s = &rl_surfaces[surface];
+    int width = (int)s->bounds.width, height = (int)s->bounds.height;
+    if (width <= 0 || height <= 0) return false;
+    if (s->target.id == 0 || s->target.texture.width < width || s->target.texture.height < height) {
+        if (s->target.id != 0) UnloadRenderTexture(s->target);
+        s->target = LoadRenderTexture((width + RL_SURFACE_ALIGN - 1) / RL_SURFACE_ALIGN * RL_SURFACE_ALIGN,
+                                      (height + RL_SURFACE_ALIGN - 1) / RL_SURFACE_ALIGN * RL_SURFACE_ALIGN);
+        s->valid = false;
+    }
+    if (!s->valid) {
+        s->damage = (Rectangle){ 0, 0, width, height };
+        s->shift = (Vector2){ 0, 0 };
+        s->exposed = (Rectangle){ 0, 0, 0, 0 };
+    }
+    s->damage = rect_intersect(s->damage, (Rectangle){ 0, 0, width, height });
+    s->exposed = rect_intersect(s->exposed, (Rectangle){ 0, 0, width, height });
+    // The two regions are drawn one after the other, so they must not overlap
+    if (rl_rects_overlap(s->damage, s->exposed)) {
+        s->damage = rl_rect_union(s->damage, s->exposed);
+        s->exposed = (Rectangle){ 0, 0, 0, 0 };
+    }
+    if ((s->damage.width <= 0 || s->damage.height <= 0) && (s->exposed.width <= 0 || s->exposed.height <= 0)) return false;
+
+    rl_surface_current = surface;
+    rl_surface_first = rl_cmd_count;
+    rl_surface_scissor = rl_scissor_current;
+    rl_surface_top_layer = rl_cmd_top_layer;
+    rl_scissor_current = 0;
+    rl_cmd_origin = (Vector2){ s->bounds.x, s->bounds.y };
+    rl_cmd_frame++;  // the surface's commands are ordered on a fresh tile grid
+    rl_cmd_floor = rl_cmd_top_layer = 0;
+    return true;
+}
+
+// Damage that lay in a scrolled area, where it is after the scroll as well
+static Rectangle rl_surface_shift_damage(Rectangle damage, Rectangle area, float dx, float dy) {
+    if (!rl_rects_overlap(damage, area)) return damage;
+    Rectangle moved = rect_intersect(damage, area);
+    moved.x += dx;
+    moved.y += dy;
+    moved = rect_intersect(moved, area);
+    return moved.width > 0 && moved.height > 0 ? rl_rect_union(damage, moved) : damage;
+}
+
+// Scroll part of a surface's contents by (dx, dy) pixels without redrawing it.
+// The pixels already in the texture are copied over and only the strip that
+// scrolled into view is damaged, so a list scrolled by a few pixels redraws a
+// few pixels' worth of rows. `area` is in screen coordinates, like the draw_*
+// calls. Scrolls of the same area add up until the surface is next drawn;
+// anything the copy cannot produce (a different area, a jump of more than the
+// area, a fraction of a pixel, contents never drawn) falls back to damaging
+// the whole area.
+void scroll_surface(int surface, Rectangle area, float dx, float dy) {
+    rl_surface *s = &rl_surfaces[surface];
+    area.x += rl_translation.x;
+    area.y += rl_translation.y;
+    area = rect_intersect(area, s->bounds);
+    if (area.width <= 0 || area.height <= 0 || (dx == 0 && dy == 0)) return;
+    Rectangle local = { area.x - s->bounds.x, area.y - s->bounds.y, area.width, area.height };
+    bool pending = s->shift.x != 0 || s->shift.y != 0;
+    bool same_area = local.x == s->shift_area.x && local.y == s->shift_area.y &&
+                     local.width == s->shift_area.width && local.height == s->shift_area.height;
+    float total_x = s->shift.x + dx, total_y = s->shift.y + dy;
+    bool whole_pixels = dx == (float)(int)dx && dy == (float)(int)dy;
+    if (!s->valid || s->target.id == 0 || (pending && !same_area) || !whole_pixels ||
+        (total_x < 0 ? -total_x : total_x) >= local.width || (total_y < 0 ? -total_y : total_y) >= local.height) {
+        if (pending) {
+            s->damage = rl_rect_union(s->damage, s->shift_area);
+            s->shift = (Vector2){ 0, 0 };
+        }
+        s->damage = rl_rect_union(s->damage, s->exposed);
+        s->exposed = (Rectangle){ 0, 0, 0, 0 };
+        damage_rect((Rectangle){ area.x - rl_translation.x, area.y - rl_translation.y, area.width, area.height });
+        return;
+    }
+    // Whatever was waiting to be redrawn inside the area moves along with it
+    s->damage = rl_surface_shift_damage(s->damage, local, dx, dy);
+    s->exposed = rl_surface_shift_damage(s->exposed, local, dx, dy);
+    // The strips the copy leaves uncovered
+    if (dy > 0) s->exposed = rl_rect_union(s->exposed, (Rectangle){ local.x, local.y, local.width, dy });
+    if (dy < 0) s->exposed = rl_rect_union(s->exposed, (Rectangle){ local.x, local.y + local.height + dy, local.width, -dy });
+    if (dx > 0) s->exposed = rl_rect_union(s->exposed, (Rectangle){ local.x, local.y, dx, local.height });
+    if (dx < 0) s->exposed = rl_rect_union(s->exposed, (Rectangle){ local.x + local.width + dx, local.y, -dx, local.height });
+    s->shift_area = local;
+    s->shift.x += dx;
+    s->shift.y += dy;
+    rl_damage_add(area);
+}
+
+// Carry out a pending scroll_surface(): copy the target into the scratch
+// texture, shifted inside the scrolled area, and swap the two
+static void rl_surface_shift(rl_surface *s) {
+    int width = s->target.texture.width, height = s->target.texture.height;
+    if (s->scratch.id == 0 || s->scratch.texture.width != width || s->scratch.texture.height != height) {
+        if (s->scratch.id != 0) UnloadRenderTexture(s->scratch);
+        s->scratch = LoadRenderTexture(width, height);
+    }
+    Rectangle source = { 0, 0, (float)width, -(float)height };  // render textures are stored bottom-up
+    BeginTextureMode(s->scratch);
+    ClearBackground((Color){ 0, 0, 0, 0 });
+    DrawTextureRec(s->target.texture, source, (Vector2){ 0, 0 }, WHITE);
+    BeginScissorMode((int)s->shift_area.x, (int)s->shift_area.y, (int)s->shift_area.width, (int)s->shift_area.height);
+    DrawTextureRec(s->target.texture, source, s->shift, WHITE);
+    EndScissorMode();
+    EndTextureMode();
+    RenderTexture2D target = s->target;
+    s->target = s->scratch;
+    s->scratch = target;
+    s->shift = (Vector2){ 0, 0 };
+    rl_stats.surfaces_scrolled++;
+}
+
+// Draw the surface's damaged contents into its texture and record the quad that shows it
+void end_surface(int surface) {
+    rl_surface *s = &rl_surfaces[surface];
+    if (rl_surface_current == surface) {
+        if (s->shift.x != 0 || s->shift.y != 0) rl_surface_shift(s);
+        rl_draw_cmd *cmds = rl_cmds + rl_surface_first;
+        int count = rl_cmd_count - rl_surface_first;
+        qsort(cmds, count, sizeof(rl_draw_cmd), rl_cmd_compare);
+        Rectangle clip = { 0, 0, 0, 0 };
+        BeginTextureMode(s->target);
+        if (s->damage.width > 0 && s->damage.height > 0) rl_cmd_draw_region(cmds, count, s->damage, false, &clip);
+        if (s->exposed.width > 0 && s->exposed.height > 0) rl_cmd_draw_region(cmds, count, s->exposed, false, &clip);
+        rl_set_scissor(&clip, (Rectangle){ 0, 0, 0, 0 });
+        EndTextureMode();
+        rl_stats.surfaces_redrawn++;
+        s->damage = (Rectangle){ 0, 0, 0, 0 };
+        s->exposed = (Rectangle){ 0, 0, 0, 0 };
+        s->valid = true;
+
+        // Back to the screen. Its tile grid was reused, so later commands go above everything so far.
+        rl_cmd_count = rl_surface_first;
+        rl_surface_current = -1;
+        rl_scissor_current = rl_surface_scissor;
+        rl_cmd_origin = (Vector2){ 0, 0 };
+        rl_cmd_frame++;
+        rl_cmd_floor = rl_cmd_top_layer = rl_surface_top_layer + 1;
+    }
+    if (s->bounds.width <= 0 || s->bounds.height <= 0) return;
+    rl_draw_cmd *cmd = rl_cmd_push();
+    cmd->type = RL_CMD_SURFACE;
+    cmd->batch = RL_BATCH_SURFACE;
+    cmd->surface = surface;
+    cmd->x = s->bounds.x;
+    cmd->y = s->bounds.y;
+    cmd->w = (int)s->bounds.width;
+    cmd->h = (int)s->bounds.height;
+    cmd->color = COLOR_WHITE;  // no tint
+    cmd->bounds = s->bounds;
+    rl_cmd_finish(cmd);
+}
+
+//--------------------------- Text metrics ---------------------------
+// measure_text() returns the same width as MeasureText, but remembers the
+// glyph advances of every string it has seen in a hash table keyed by the
+// string's contents. Measuring an unchanged label again only hashes it, and
+// a string that extends a known one by a character (typing) only adds that
+// character's advance. Advances are kept in font units, so one entry serves
+// every font size.
+
+#define RL_TEXT_CACHE_SIZE 4096    // entries, a power of two
+#define RL_TEXT_CACHE_PROBES 8     // slots searched before an entry is evicted
+
+// Line state of a measured string, as accumulated by raylib's MeasureTextEx
+typedef struct {
+    uint64_t hash;         // FNV-1a of the bytes, 0 = empty slot
+    uint32_t length;       // bytes
+    float line_units;      // advance of the last line, in font units
+    float max_units;       // widest line before it
+    int line_chars;        // codepoints on the last line
+    int max_chars;         // most codepoints on any line
+} rl_text_metrics;
+
+static rl_text_metrics rl_text_cache[RL_TEXT_CACHE_SIZE];
+static float rl_glyph_units[128];          // ASCII advances in font units, filled on first use
+static bool rl_glyph_units_ready = false;
+
+// Advance of a codepoint in font units
+static float rl_glyph_advance_units(int codepoint) {
+#ifdef RUI_HEADLESS
+    return headless_glyph_units(codepoint);
+#else
+    Font font = GetFontDefault();
+    if (font.glyphs == NULL) return 0;  // no window yet
+    int index = GetGlyphIndex(font, codepoint);
+    if (font.glyphs[index].advanceX != 0) return font.glyphs[index].advanceX;
+    return font.recs[index].width + font.glyphs[index].offsetX;
+#endif
+}
+
+static float rl_glyph_units_of(int codepoint) {
+    if (!rl_glyph_units_ready) {
+#ifndef RUI_HEADLESS
+        if (GetFontDefault().glyphs == NULL) return 0;
+#endif
+        for (int c = 0; c < 128; c++) rl_glyph_units[c] = rl_glyph_advance_units(c);
+        rl_glyph_units_ready = true;
+    }
+    return codepoint < 128 ? rl_glyph_units[codepoint] : rl_glyph_advance_units(codepoint);
+}
+
+static void rl_text_metrics_add(rl_text_metrics *m, int codepoint) {
+    m->line_chars++;
+    if (codepoint == '\n') {
+        if (m->line_units > m->max_units) m->max_units = m->line_units;
+        m->line_units = 0;
+        m->line_chars = 0;
+    } else {
+        m->line_units += rl_glyph_units_of(codepoint);
+    }
+    if (m->line_chars > m->max_chars) m->max_chars = m->line_chars;
+}
+
+// Pixels per font unit at `font_size`, and the gap DrawText leaves between glyphs
+static void rl_text_scale(int font_size, float *scale, int *spacing) {
+#ifdef RUI_HEADLESS
+    *scale = headless_unit_scale(font_size);
+    *spacing = 0;
+#else
+    Font font = GetFontDefault();
+    if (font_size < 10) font_size = 10;
+    *scale = font_size / (float)font.baseSize;
+    *spacing = font_size / 10;
+#endif
+}
+
+static int rl_text_metrics_width(const rl_text_metrics *m, int font_size) {
+    float units = m->line_units > m->max_units ? m->line_units : m->max_units;
+    float scale;
+    int spacing;
+    rl_text_scale(font_size, &scale, &spacing);
+    // Same arithmetic as MeasureText
+    return (int)(units * scale + (float)((m->max_chars - 1) * spacing));
+}
+
+static rl_text_metrics *rl_text_cache_find(uint64_t hash, uint32_t length) {
+    for (int i = 0; i < RL_TEXT_CACHE_PROBES; i++) {
+        rl_text_metrics *m = &rl_text_cache[(hash + i) & (RL_TEXT_CACHE_SIZE - 1)];
+        if (m->hash == hash && m->length == length) return m;
+        if (m->hash == 0) return NULL;
+    }
+    return NULL;
+}
+
+static void rl_text_cache_store(const rl_text_metrics *metrics) {
+    rl_text_metrics *slot = &rl_text_cache[metrics->hash & (RL_TEXT_CACHE_SIZE - 1)];
+    for (int i = 0; i < RL_TEXT_CACHE_PROBES; i++) {
+        rl_text_metrics *m = &rl_text_cache[(metrics->hash + i) & (RL_TEXT_CACHE_SIZE - 1)];
+        if (m->hash == 0) {
+            slot = m;
+            break;
+        }
+    }
+    *slot = *metrics;
+}
+
+// Distance the pen moves past `codepoint` when drawing text, including the spacing between glyphs
+float measure_glyph(int codepoint, int font_size) {
+    float scale;
+    int spacing;
+    rl_text_scale(font_size, &scale, &spacing);
+    return rl_glyph_units_of(codepoint) * scale + spacing;
+}
+
+// Distance the pen moves over the first `length` bytes of a single line of text
+float measure_text_advance(const char *text, int length, int font_size) {
+    float scale;
+    int spacing;
+    rl_text_scale(font_size, &scale, &spacing);
+    float advance = 0;
+    for (int i = 0; i < length;) {
+        int size = 1;
+        int codepoint = (unsigned char)text[i];
+        if (codepoint >= 0x80) codepoint = GetCodepointNext(text + i, &size);
+        advance += rl_glyph_units_of(codepoint) * scale + spacing;
+        i += size;
+    }
+    return advance;
+}
+
+// Pen position after each byte of a single line of text: x[i + 1] is the
+// pen after text[i], starting from the caller's x[0]. The bytes of a
+// multi-byte codepoint all get the position after the whole codepoint.
+void measure_text_positions(const char *text, int length, int font_size, float *x) {
+    float scale;
+    int spacing;
+    rl_text_scale(font_size, &scale, &spacing);
+    for (int i = 0; i < length;) {
+        int size = 1;
+        int codepoint = (unsigned char)text[i];
+        if (codepoint >= 0x80) codepoint = GetCodepointNext(text + i, &size);
+        if (size > length - i) size = length - i;
+        float next = x[i] + rl_glyph_units_of(codepoint) * scale + spacing;
+        for (int k = 1; k <= size; k++) x[i + k] = next;
+        i += size;
+    }
+}
+
+// Width in pixels of the widest line of `text` in the default font
+int measure_text(const char *text, int font_size) {
+    if (text == NULL || text[0] == '\0') return 0;
+#ifndef RUI_HEADLESS
+    if (GetFontDefault().texture.id == 0) return 0;  // no window yet, like MeasureText
+#endif
+    // Hash the string, remembering the hash up to the start of its last codepoint
+    uint64_t hash = 14695981039346656037ULL;
+    uint64_t prefix_hash = hash;
+    uint32_t prefix_length = 0;
+    uint32_t length = 0;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++, length++) {
+        if ((*c & 0xC0) != 0x80) {
+            prefix_hash = hash;
+            prefix_length = length;
+        }
+        hash = (hash ^ *c) * 1099511628211ULL;
+    }
+    if (hash == 0) hash = 1;
+    if (prefix_hash == 0) prefix_hash = 1;
+
+    rl_text_metrics *cached = rl_text_cache_find(hash, length);
+    if (cached) return rl_text_metrics_width(cached, font_size);
+
+    rl_text_metrics metrics = {0};
+    rl_text_metrics *prefix = prefix_length > 0 ? rl_text_cache_find(prefix_hash, prefix_length) : NULL;
+    const char *rest = text;
+    if (prefix) {
+        metrics = *prefix;
+        rest = text + prefix_length;
+    }
+    while (*rest) {
+        int size = 0;
+        int codepoint = GetCodepointNext(rest, &size);
+        rl_text_metrics_add(&metrics, codepoint);
+        rest += size;
+    }
+    metrics.hash = hash;
+    metrics.length = length;
+    rl_text_cache_store(&metrics);
+    return rl_text_metrics_width(&metrics, font_size);
+}
+
+//--------------------------- Frame pacing ---------------------------
+// PACING_FIXED runs the loop at the target FPS forever, like plain raylib.
+// PACING_ON_DEMAND sleeps in end_drawing() until there is input, a frame
+// asked for with request_frame_in() is due (e.g. the next cursor blink), or
+// another thread calls post_wakeup(). Interactions that need smooth motion,
+// such as window drags, call request_high_refresh() every frame to run at
+// the monitor's refresh rate for as long as they last.
+
+typedef enum {
+    PACING_FIXED,
+    PACING_ON_DEMAND
+} RL_PACING_MODE;
+
+static RL_PACING_MODE rl_pacing = PACING_FIXED;
+static int rl_target_fps = 60;
+static double rl_next_frame = -1;            // GetTime() of the earliest requested frame, -1 = none
+static bool rl_high_refresh_requested = false;
+static bool rl_high_refresh = false;
+static bool rl_window_ready = false;
+
+#ifndef RUI_HEADLESS
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+// Part of the GLFW copy built into desktop raylib; wakes up a blocked PollInputEvents from any thread.
+// Weak so builds against a raylib that hides GLFW still link (on-demand pacing then stays off).
+void glfwPostEmptyEvent(void) __attribute__((weak));
+
+// Helper thread that posts an empty event when the earliest requested frame is due
+static pthread_t rl_timer_thread;
+static pthread_mutex_t rl_timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rl_timer_cond;
+static struct timespec rl_timer_deadline;
+static bool rl_timer_armed = false;
+static bool rl_timer_running = false;
+
+static void *rl_timer_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&rl_timer_lock);
+    while (rl_timer_running) {
+        if (!rl_timer_armed) {
+            pthread_cond_wait(&rl_timer_cond, &rl_timer_lock);
+        } else if (pthread_cond_timedwait(&rl_timer_cond, &rl_timer_lock, &rl_timer_deadline) == ETIMEDOUT) {
+            rl_timer_armed = false;
+            pthread_mutex_unlock(&rl_timer_lock);
+            glfwPostEmptyEvent();
+            pthread_mutex_lock(&rl_timer_lock);
+        }
+    }
+    pthread_mutex_unlock(&rl_timer_lock);
+    return NULL;
+}
+
+static void rl_timer_start(void) {
+    if (rl_timer_running) return;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&rl_timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    rl_timer_running = true;
+    rl_timer_armed = false;
+    pthread_create(&rl_timer_thread, NULL, rl_timer_main, NULL);
+}
+
+static void rl_timer_stop(void) {
+    if (!rl_timer_running) return;
+    pthread_mutex_lock(&rl_timer_lock);
+    rl_timer_running = false;
+    pthread_cond_signal(&rl_timer_cond);
+    pthread_mutex_unlock(&rl_timer_lock);
+    pthread_join(rl_timer_thread, NULL);
+    pthread_cond_destroy(&rl_timer_cond);
+}
+
+// Wake the loop `seconds` from now; a negative value cancels the timer
+static void rl_timer_arm(double seconds) {
+    pthread_mutex_lock(&rl_timer_lock);
+    rl_timer_armed = seconds >= 0;
+    if (rl_timer_armed) {
+        clock_gettime(CLOCK_MONOTONIC, &rl_timer_deadline);
+        long long ns = rl_timer_deadline.tv_nsec + (long long)(seconds * 1e9);
+        rl_timer_deadline.tv_sec += ns / 1000000000;
+        rl_timer_deadline.tv_nsec = ns % 1000000000;
+    }
+    pthread_cond_signal(&rl_timer_cond);
+    pthread_mutex_unlock(&rl_timer_lock);
+}
+#endif
+
+static void rl_pacing_apply(void) {
+    if (!rl_window_ready) return;
+#ifndef RUI_HEADLESS
+    if (rl_pacing == PACING_ON_DEMAND && !glfwPostEmptyEvent) {
+        TraceLog(LOG_WARNING, "RUI: raylib does not export glfwPostEmptyEvent, using fixed frame pacing");
+        rl_pacing = PACING_FIXED;
+    }
+    bool waiting = rl_pacing == PACING_ON_DEMAND && !rl_high_refresh;
+    if (waiting) {
+        rl_timer_start();
+        EnableEventWaiting();
+    } else {
+        DisableEventWaiting();
+        if (rl_pacing == PACING_FIXED) rl_timer_stop();
+    }
+    SetTargetFPS(rl_high_refresh ? GetMonitorRefreshRate(GetCurrentMonitor()) : rl_target_fps);
+#else
+    SetTargetFPS(rl_target_fps);  // the headless backend never sleeps
+#endif
+}
+
+void set_frame_pacing(RL_PACING_MODE mode) {
+    rl_pacing = mode;
+    rl_pacing_apply();
+}
+
+RL_PACING_MODE get_frame_pacing() {
+    return rl_pacing;
+}
+
+// Frame rate cap; in PACING_ON_DEMAND it bounds how fast input bursts are drawn
+void set_target_fps(int fps) {
+    rl_target_fps = fps;
+    rl_pacing_apply();
+}
+
+// Ask for a frame `seconds` from now even if no input arrives (animation timers)
+void request_frame_in(double seconds) {
+    double at = GetTime() + (seconds > 0 ? seconds : 0);
+    if (rl_next_frame < 0 || at < rl_next_frame) rl_next_frame = at;
+}
+
+// Run at the monitor refresh rate for the next frame; call it every frame an interaction lasts
+void request_high_refresh() {
+    rl_high_refresh_requested = true;
+}
+
+// Wake a loop sleeping in PACING_ON_DEMAND; safe to call from any thread
+void post_wakeup() {
+#ifndef RUI_HEADLESS
+    if (rl_window_ready && glfwPostEmptyEvent) glfwPostEmptyEvent();
+#endif
+}
+
+// Called by end_drawing() right before the loop may sleep waiting for input
+static void rl_pacing_before_wait(void) {
+    bool high = rl_high_refresh_requested;
+    rl_high_refresh_requested = false;
+    if (high != rl_high_refresh) {
+        rl_high_refresh = high;
+        rl_pacing_apply();
+    }
+#ifndef RUI_HEADLESS
+    if (rl_pacing == PACING_ON_DEMAND && !rl_high_refresh) {
+        rl_timer_arm(rl_next_frame < 0 ? -1 : (rl_next_frame > GetTime() ? rl_next_frame - GetTime() : 0));
+    }
+#endif
+    rl_next_frame = -1;
+}
+
+//--------------------------- Keyboard events ---------------------------
+// raylib hands out a frame's key presses and characters from two queues of
+// 16, without their times or the releases between them, and drops whatever
+// does not fit. Where raylib's GLFW is reachable, rl.h also listens to the
+// key and character callbacks, passing each event on to raylib's own, and
+// keeps every press, release and character in order with the time it
+// arrived. The headless backend reports its scripted events the same way.
+
+typedef enum {
+    RL_KEY_PRESS,
+    RL_KEY_RELEASE,
+    RL_KEY_CHAR
+} rl_key_action;
+
+typedef struct {
+    double time;            // GetTime() when the event arrived
+    int code;               // Key, or the codepoint of a RL_KEY_CHAR
+    rl_key_action action;
+} rl_key_event;
+
+#define RL_MAX_KEY_EVENTS 256  // kept between two take_key_events; later ones are dropped
+
+#ifndef RUI_HEADLESS
+typedef struct GLFWwindow GLFWwindow;
+typedef void (*GLFWkeyfun)(GLFWwindow *window, int key, int scancode, int action, int mods);
+typedef void (*GLFWcharfun)(GLFWwindow *window, unsigned int codepoint);
+
+// Weak like glfwPostEmptyEvent; without them poll_input reads raylib's queues
+GLFWkeyfun glfwSetKeyCallback(GLFWwindow *window, GLFWkeyfun callback) __attribute__((weak));
+GLFWcharfun glfwSetCharCallback(GLFWwindow *window, GLFWcharfun callback) __attribute__((weak));
+
+static rl_key_event rl_key_events[RL_MAX_KEY_EVENTS];
+static int rl_key_event_count = 0;
+static bool rl_key_hooked = false;
+static GLFWkeyfun rl_raylib_key_callback = NULL;   // raylib's callbacks, called after ours
+static GLFWcharfun rl_raylib_char_callback = NULL;
+
+static void rl_key_event_add(rl_key_action action, int code) {
+    if (rl_key_event_count < RL_MAX_KEY_EVENTS) rl_key_events[rl_key_event_count++] = (rl_key_event){ GetTime(), code, action };
+}
+
+static void rl_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    // GLFW_RELEASE is 0 and GLFW_PRESS 1; its repeats (2) follow the OS rate, so they are left out
+    if (action == 1) rl_key_event_add(RL_KEY_PRESS, key);
+    else if (action == 0) rl_key_event_add(RL_KEY_RELEASE, key);
+    if (rl_raylib_key_callback) rl_raylib_key_callback(window, key, scancode, action, mods);
+}
+
+static void rl_char_callback(GLFWwindow *window, unsigned int codepoint) {
+    rl_key_event_add(RL_KEY_CHAR, (int)codepoint);
+    if (rl_raylib_char_callback) rl_raylib_char_callback(window, codepoint);
+}
+
+// Put our callbacks in front of raylib's, or give raylib its own back
+static void rl_key_hook(bool hook) {
+    if (!glfwSetKeyCallback || !glfwSetCharCallback || hook == rl_key_hooked) return;
+    GLFWwindow *window = GetWindowHandle();
+    if (hook) {
+        rl_raylib_key_callback = glfwSetKeyCallback(window, rl_key_callback);
+        rl_raylib_char_callback = glfwSetCharCallback(window, rl_char_callback);
+    } else {
+        glfwSetKeyCallback(window, rl_raylib_key_callback);
+        glfwSetCharCallback(window, rl_raylib_char_callback);
+    }
+    rl_key_hooked = hook;
+    rl_key_event_count = 0;
+}
+#endif
+
+// Copy the keyboard events that arrived since the last call to `events`, in
+// order; returns how many, at most `max`, or -1 when the backend does not
+// report them and raylib's key and character queues have to be read instead
+int take_key_events(rl_key_event *events, int max) {
+#ifndef RUI_HEADLESS
+    if (!rl_key_hooked) return -1;
+    int count = rl_key_event_count < max ? rl_key_event_count : max;
+    memcpy(events, rl_key_events, count * sizeof(rl_key_event));
+    rl_key_event_count = 0;
+    return count;
+#else
+    const headless_event *script;
+    int available = headless_take_key_events(&script);
+    double now = GetTime();
+    int count = 0;
+    for (int i = 0; i < available && count < max; i++) {
+        rl_key_action action = script[i].type == HEADLESS_EVENT_KEY_DOWN ? RL_KEY_PRESS
+                             : script[i].type == HEADLESS_EVENT_KEY_UP ? RL_KEY_RELEASE : RL_KEY_CHAR;
+        events[count++] = (rl_key_event){ now, script[i].value, action };
+    }
+    return count;
+#endif
+}
+
+//--------------------------- Frame ---------------------------
+
+#ifndef RUI_HEADLESS
+static double rl_frame_start = 0;        // when the last frame was presented or dropped
+static RenderTexture2D rl_canvas = {0};  // persistent copy of the screen
+#endif
+
+// Start a frame; draw_* calls are recorded until end_drawing()
+void begin_drawing() {
+    if (IsWindowResized()) damage_screen();
+    int tiles_x = GetScreenWidth() / RL_CMD_TILE + 1;
+    int tiles_y = GetScreenHeight() / RL_CMD_TILE + 1;
+    if (tiles_x != rl_cmd_tiles_x || tiles_y != rl_cmd_tiles_y) {
+        rl_cmd_tiles = realloc(rl_cmd_tiles, tiles_x * tiles_y * sizeof(rl_cmd_tile));
+        memset(rl_cmd_tiles, 0, tiles_x * tiles_y * sizeof(rl_cmd_tile));
+        rl_cmd_tiles_x = tiles_x;
+        rl_cmd_tiles_y = tiles_y;
+    }
+    rl_cmd_frame++;
+    rl_cmd_count = 0;
+    rl_cmd_text_size = 0;
+    rl_cmd_floor = rl_cmd_top_layer = 0;
+    rl_scissor_count = 1;
+    rl_scissor_current = 0;
+    rl_scissor_depth = 0;
+    rl_translation_depth = 0;
+    rl_translation = (Vector2){ 0, 0 };
+    rl_stats = (rl_draw_stats){0};
+    rl_stats.begin_time = GetTime();
+}
+
+// Redraw the damaged regions with the recorded commands and present the frame.
+// Without damage the frame is dropped and only input is polled.
+void end_drawing() {
+    rl_pacing_before_wait();
+    if (!has_damage()) {
+        rl_stats.commands = rl_cmd_count;
+        rl_stats.draw_seconds = GetTime() - rl_stats.begin_time;
+#ifdef RUI_HEADLESS
+        EndDrawing();  // the framebuffer already holds the last frame
+#else
+        // Blocks until input or a wakeup in PACING_ON_DEMAND
+        PollInputEvents();
+        if (rl_pacing == PACING_FIXED || rl_high_refresh) {
+            // Keep the FPS limit that EndDrawing would have applied
+            int fps = rl_high_refresh ? GetMonitorRefreshRate(GetCurrentMonitor()) : rl_target_fps;
+            double wait = fps > 0 ? 1.0 / fps - (GetTime() - rl_frame_start) : 0;  // 0 = no limit, as in SetTargetFPS
+            if (wait > 0) WaitTime(wait);
+        }
+        rl_frame_start = GetTime();
+#endif
+        return;
+    }
+#ifdef RUI_HEADLESS
+    // The CPU framebuffer persists between frames, so damaged regions are redrawn in place
+    BeginDrawing();
+    rl_cmd_flush();
+    rl_stats.draw_seconds = GetTime() - rl_stats.begin_time;
+    EndDrawing();
+#else
+    // The back buffer is undefined after a swap, so frames are kept in a canvas texture
+    int width = GetScreenWidth(), height = GetScreenHeight();
+    if (rl_canvas.id == 0 || rl_canvas.texture.width != width || rl_canvas.texture.height != height) {
+        if (rl_canvas.id != 0) UnloadRenderTexture(rl_canvas);
+        rl_canvas = LoadRenderTexture(width, height);
+        damage_screen();
+    }
+    BeginTextureMode(rl_canvas);
+    rl_cmd_flush();
+    EndTextureMode();
+    BeginDrawing();
+    DrawTextureRec(rl_canvas.texture, (Rectangle){ 0, 0, width, -height }, (Vector2){ 0, 0 }, WHITE);
+    rl_stats.draw_seconds = GetTime() - rl_stats.begin_time;
+    EndDrawing();
+    rl_frame_start = GetTime();
+#endif
+    rl_stats.presented = true;
+    rl_damage_count = 0;
+    rl_damage_everything = false;
+}
+
+// Fill the damaged part of the screen; call it before any other draw_* of the frame
+void clear_background(RUI_COLOR color) {
+    rl_draw_cmd *cmd = rl_cmd_push();
+    cmd->type = RL_CMD_CLEAR;
+    cmd->batch = RL_BATCH_SHAPES;
+    cmd->color = color;
+    cmd->bounds = (Rectangle){ 0, 0, GetScreenWidth(), GetScreenHeight() };
+    rl_cmd_finish(cmd);
 }
 
 // Function to initialize the window
 void init(char * title, int w, int h) {
     InitWindow(w, h, title);  // Corrected to match raylib InitWindow signature
-    SetTargetFPS(60);  // Set FPS limit
+    rl_window_ready = true;
+#ifndef RUI_HEADLESS
+    rl_key_hook(true);
+#endif
+    rl_pacing_apply();  // Set FPS limit and pacing mode
+    damage_screen();
 }
 
 // Function to close the window
 void quit() {
+    free(rl_cmds);
+    free(rl_cmd_tiles);
+    free(rl_cmd_text);
+    for (int i = 0; i < RL_MAX_SURFACES; i++) unload_surface(i);
+    memset(rl_text_cache, 0, sizeof(rl_text_cache));
+    rl_glyph_units_ready = false;
+    rl_cmds = NULL;
+    rl_cmd_tiles = NULL;
+    rl_cmd_tiles_x = rl_cmd_tiles_y = 0;
+    rl_cmd_text = NULL;
+    rl_cmd_count = rl_cmd_capacity = 0;
+    rl_cmd_text_size = rl_cmd_text_capacity = 0;
+#ifndef RUI_HEADLESS
+    if (rl_canvas.id != 0) UnloadRenderTexture(rl_canvas);
+    rl_canvas = (RenderTexture2D){0};
+    rl_timer_stop();
+    rl_key_hook(false);
+#endif
+    rl_window_ready = false;
     CloseWindow();  // Clean up and close the window
 }
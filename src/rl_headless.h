@@ -0,0 +1,1283 @@
+// Headless CPU backend for rl.h, selected with -DRUI_HEADLESS.
+//
+// Provides the subset of the raylib API that rl.h and rui.h use, implemented
+// against an in-memory RGBA framebuffer instead of a GPU window. Text is
+// rasterized from the bundled assets/DejaVuSans.ttf and input comes from a
+// script instead of a keyboard and mouse, so UI scenes can run in CI on
+// machines without a display or GPU.
+//
+// Environment variables read by InitWindow():
+//   RUI_FONT             path of the TrueType font (default RUI_FONT_PATH)
+//   RUI_HEADLESS_FRAMES  number of frames after which WindowShouldClose() returns true
+//   RUI_HEADLESS_SCRIPT  text file of input events, one per line:
+//                          <frame> move <x> <y>
+//                          <frame> down|up <mouse button>
+//                          <frame> wheel <amount>
+//                          <frame> key_down|key_up <key code>
+//                          <frame> char <character or code>
+//                          <frame> quit
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+
+#ifndef RUI_FONT_PATH
+#define RUI_FONT_PATH "assets/DejaVuSans.ttf"
+#endif
+
+#define HEADLESS_MAX_KEYS 512
+#define HEADLESS_MAX_MOUSE_BUTTONS 3
+#define HEADLESS_QUEUE_SIZE 16       // pending key presses / chars per frame, as in raylib (MAX_KEY_PRESSED_QUEUE, MAX_CHAR_PRESSED_QUEUE)
+#define HEADLESS_MAX_KEY_EVENTS 256  // key downs, ups and chars per frame kept in order for headless_take_key_events
+#define HEADLESS_GLYPH_SIZES 16      // distinct font sizes kept in the glyph cache
+#define HEADLESS_MAX_TEXTURES 64     // render textures alive at the same time
+
+//--------------------------- raylib types ---------------------------
+
+typedef struct Vector2 {
+    float x;
+    float y;
+} Vector2;
+
+typedef struct Color {
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char a;
+} Color;
+
+typedef struct Rectangle {
+    float x;
+    float y;
+    float width;
+    float height;
+} Rectangle;
+
+typedef struct Texture {
+    unsigned int id;             // 1-based index into the backend's texture table, 0 = none
+    int width;
+    int height;
+    int mipmaps;
+    int format;
+} Texture;
+typedef Texture Texture2D;
+
+typedef struct RenderTexture {
+    unsigned int id;
+    Texture texture;
+    Texture depth;               // unused
+} RenderTexture;
+typedef RenderTexture RenderTexture2D;
+
+#define LIGHTGRAY  (Color){ 200, 200, 200, 255 }
+#define GRAY       (Color){ 130, 130, 130, 255 }
+#define DARKGRAY   (Color){ 80, 80, 80, 255 }
+#define YELLOW     (Color){ 253, 249, 0, 255 }
+#define GOLD       (Color){ 255, 203, 0, 255 }
+#define ORANGE     (Color){ 255, 161, 0, 255 }
+#define PINK       (Color){ 255, 109, 194, 255 }
+#define RED        (Color){ 230, 41, 55, 255 }
+#define MAROON     (Color){ 190, 33, 55, 255 }
+#define GREEN      (Color){ 0, 228, 48, 255 }
+#define LIME       (Color){ 0, 158, 47, 255 }
+#define DARKGREEN  (Color){ 0, 117, 44, 255 }
+#define SKYBLUE    (Color){ 102, 191, 255, 255 }
+#define BLUE       (Color){ 0, 121, 241, 255 }
+#define DARKBLUE   (Color){ 0, 82, 172, 255 }
+#define PURPLE     (Color){ 200, 122, 255, 255 }
+#define VIOLET     (Color){ 135, 60, 190, 255 }
+#define DARKPURPLE (Color){ 112, 31, 126, 255 }
+#define BEIGE      (Color){ 211, 176, 131, 255 }
+#define BROWN      (Color){ 127, 106, 79, 255 }
+#define DARKBROWN  (Color){ 76, 63, 47, 255 }
+#define WHITE      (Color){ 255, 255, 255, 255 }
+#define BLACK      (Color){ 0, 0, 0, 255 }
+#define BLANK      (Color){ 0, 0, 0, 0 }
+#define MAGENTA    (Color){ 255, 0, 255, 255 }
+#define RAYWHITE   (Color){ 245, 245, 245, 255 }
+
+typedef enum {
+    LOG_ALL = 0,
+    LOG_TRACE,
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR,
+    LOG_FATAL,
+    LOG_NONE
+} TraceLogLevel;
+
+typedef enum {
+    MOUSE_BUTTON_LEFT = 0,
+    MOUSE_BUTTON_RIGHT = 1,
+    MOUSE_BUTTON_MIDDLE = 2
+} MouseButton;
+
+#define MOUSE_LEFT_BUTTON   MOUSE_BUTTON_LEFT
+#define MOUSE_RIGHT_BUTTON  MOUSE_BUTTON_RIGHT
+#define MOUSE_MIDDLE_BUTTON MOUSE_BUTTON_MIDDLE
+
+// Same codes as raylib (which uses the GLFW ones)
+typedef enum {
+    KEY_NULL = 0,
+    KEY_SPACE = 32,
+    KEY_ZERO = 48, KEY_ONE, KEY_TWO, KEY_THREE, KEY_FOUR, KEY_FIVE, KEY_SIX, KEY_SEVEN, KEY_EIGHT, KEY_NINE,
+    KEY_A = 65, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+    KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z,
+    KEY_GRAVE = 96,
+    KEY_ESCAPE = 256,
+    KEY_ENTER = 257,
+    KEY_TAB = 258,
+    KEY_BACKSPACE = 259,
+    KEY_INSERT = 260,
+    KEY_DELETE = 261,
+    KEY_RIGHT = 262,
+    KEY_LEFT = 263,
+    KEY_DOWN = 264,
+    KEY_UP = 265,
+    KEY_PAGE_UP = 266,
+    KEY_PAGE_DOWN = 267,
+    KEY_HOME = 268,
+    KEY_END = 269,
+    KEY_F1 = 290, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12,
+    KEY_KP_0 = 320,
+    KEY_KP_EQUAL = 336,
+    KEY_LEFT_SHIFT = 340,
+    KEY_LEFT_CONTROL = 341,
+    KEY_LEFT_ALT = 342,
+    KEY_LEFT_SUPER = 343,
+    KEY_RIGHT_SHIFT = 344,
+    KEY_RIGHT_CONTROL = 345,
+    KEY_RIGHT_ALT = 346,
+    KEY_RIGHT_SUPER = 347
+} KeyboardKey;
+
+//--------------------------- Scripted input ---------------------------
+
+typedef enum {
+    HEADLESS_EVENT_MOUSE_MOVE,   // x, y
+    HEADLESS_EVENT_MOUSE_DOWN,   // value = mouse button
+    HEADLESS_EVENT_MOUSE_UP,     // value = mouse button
+    HEADLESS_EVENT_WHEEL,        // x = wheel amount
+    HEADLESS_EVENT_KEY_DOWN,     // value = key code
+    HEADLESS_EVENT_KEY_UP,       // value = key code
+    HEADLESS_EVENT_CHAR,         // value = unicode codepoint
+    HEADLESS_EVENT_QUIT
+} headless_event_type;
+
+typedef struct {
+    int frame;                   // frame whose input state the event is part of
+    headless_event_type type;
+    float x, y;
+    int value;
+} headless_event;
+
+//--------------------------- State ---------------------------
+
+typedef struct {
+    uint8_t *pixels;             // RGBA8, row-major, top row first
+    int width;
+    int height;
+} hl_target;
+
+typedef struct {
+    int width, height;           // bitmap size
+    int x0, y0;                  // offset from pen position / baseline
+    uint8_t *alpha;              // NULL for empty glyphs (space)
+    bool loaded;
+} hl_glyph;
+
+typedef struct {
+    int size;                    // font size in pixels, 0 = slot unused
+    hl_glyph glyphs[128];        // ASCII; other codepoints are rasterized on each use
+} hl_glyph_cache;
+
+static struct {
+    hl_target screen;
+    hl_target textures[HEADLESS_MAX_TEXTURES];  // render textures, top row first like the screen
+    hl_target *target;           // screen, or a render texture
+    Rectangle clip;              // current scissor, in target pixels
+    bool scissor;
+
+    // Input: `current` is what the app sees this frame, events are applied at EndDrawing
+    Vector2 mouse;
+    bool mouse_down[HEADLESS_MAX_MOUSE_BUTTONS];
+    bool mouse_prev[HEADLESS_MAX_MOUSE_BUTTONS];
+    float wheel;
+    bool key_down[HEADLESS_MAX_KEYS];
+    bool key_prev[HEADLESS_MAX_KEYS];
+    int key_queue[HEADLESS_QUEUE_SIZE];
+    int key_queue_count;
+    int char_queue[HEADLESS_QUEUE_SIZE];
+    int char_queue_count;
+    headless_event key_events[HEADLESS_MAX_KEY_EVENTS];  // this frame's key and char events, uncapped by the queues
+    int key_event_count;
+
+    headless_event *script;
+    int script_count;
+    int script_next;
+    bool script_owned;           // loaded from RUI_HEADLESS_SCRIPT, freed on close
+    int frame_limit;             // 0 = no limit
+    bool quit;
+
+    long frame;
+    double start_time;
+    double frame_start;
+    float frame_time;
+
+    // Font
+    uint8_t *font;
+    long font_size;
+    uint32_t glyf, loca, hmtx, cmap4;
+    int units_per_em, ascender, descender;
+    int num_glyphs, num_hmetrics, loca_long;
+    hl_glyph_cache glyph_cache[HEADLESS_GLYPH_SIZES];
+    int glyph_cache_next;
+
+    char format_buffers[4][1024]; // TextFormat ring, as in raylib
+    int format_index;
+} hl = {0};
+
+static double hl_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+//--------------------------- Logging / misc ---------------------------
+
+void TraceLog(int logLevel, const char *text, ...) {
+    static const char *names[] = { "", "TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL", "" };
+    if (logLevel < LOG_INFO || logLevel >= LOG_NONE) return;
+    va_list args;
+    va_start(args, text);
+    fprintf(stderr, "%s: ", names[logLevel]);
+    vfprintf(stderr, text, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+const char *TextFormat(const char *text, ...) {
+    char *buffer = hl.format_buffers[hl.format_index];
+    hl.format_index = (hl.format_index + 1) % 4;
+    va_list args;
+    va_start(args, text);
+    vsnprintf(buffer, sizeof(hl.format_buffers[0]), text, args);
+    va_end(args);
+    return buffer;
+}
+
+bool CheckCollisionPointRec(Vector2 point, Rectangle rec) {
+    return point.x >= rec.x && point.x < rec.x + rec.width && point.y >= rec.y && point.y < rec.y + rec.height;
+}
+
+bool CheckCollisionRecs(Rectangle a, Rectangle b) {
+    return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height && a.y + a.height > b.y;
+}
+
+//--------------------------- TrueType font ---------------------------
+// Just enough of the format for horizontal text: cmap format 4, hmtx, and
+// quadratic glyf outlines (simple and composite).
+
+static uint16_t hl_u16(uint32_t at) {
+    return (uint16_t)(hl.font[at] << 8 | hl.font[at + 1]);
+}
+
+static int16_t hl_s16(uint32_t at) {
+    return (int16_t)hl_u16(at);
+}
+
+static uint32_t hl_u32(uint32_t at) {
+    return (uint32_t)hl.font[at] << 24 | (uint32_t)hl.font[at + 1] << 16 | (uint32_t)hl.font[at + 2] << 8 | hl.font[at + 3];
+}
+
+static uint32_t hl_font_table(const char *tag) {
+    int count = hl_u16(4);
+    for (int i = 0; i < count; i++) {
+        uint32_t record = 12 + 16 * i;
+        if (memcmp(hl.font + record, tag, 4) == 0) return hl_u32(record + 8);
+    }
+    return 0;
+}
+
+static bool hl_font_load(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    fseek(file, 0, SEEK_END);
+    hl.font_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    hl.font = malloc(hl.font_size);
+    if (fread(hl.font, 1, hl.font_size, file) != (size_t)hl.font_size) {
+        fclose(file);
+        free(hl.font);
+        hl.font = NULL;
+        return false;
+    }
+    fclose(file);
+
+    uint32_t head = hl_font_table("head");
+    uint32_t hhea = hl_font_table("hhea");
+    uint32_t maxp = hl_font_table("maxp");
+    uint32_t cmap = hl_font_table("cmap");
+    hl.glyf = hl_font_table("glyf");
+    hl.loca = hl_font_table("loca");
+    hl.hmtx = hl_font_table("hmtx");
+    if (!head || !hhea || !maxp || !cmap || !hl.glyf || !hl.loca || !hl.hmtx) {
+        free(hl.font);
+        hl.font = NULL;
+        return false;
+    }
+    hl.units_per_em = hl_u16(head + 18);
+    hl.loca_long = hl_s16(head + 50);
+    hl.ascender = hl_s16(hhea + 4);
+    hl.descender = hl_s16(hhea + 6);
+    hl.num_hmetrics = hl_u16(hhea + 34);
+    hl.num_glyphs = hl_u16(maxp + 4);
+
+    // Prefer the Windows Unicode BMP subtable, fall back to any Unicode one
+    hl.cmap4 = 0;
+    int subtables = hl_u16(cmap + 2);
+    for (int i = 0; i < subtables; i++) {
+        uint32_t record = cmap + 4 + 8 * i;
+        int platform = hl_u16(record), encoding = hl_u16(record + 2);
+        uint32_t offset = cmap + hl_u32(record + 4);
+        if (hl_u16(offset) != 4) continue;
+        if (platform == 3 && encoding == 1) {
+            hl.cmap4 = offset;
+            break;
+        }
+        if (platform == 0 && hl.cmap4 == 0) hl.cmap4 = offset;
+    }
+    return hl.cmap4 != 0;
+}
+
+static int hl_glyph_index(int codepoint) {
+    if (hl.font == NULL || codepoint > 0xFFFF) return 0;
+    int segments = hl_u16(hl.cmap4 + 6) / 2;
+    uint32_t ends = hl.cmap4 + 14;
+    uint32_t starts = ends + 2 * segments + 2;
+    uint32_t deltas = starts + 2 * segments;
+    uint32_t ranges = deltas + 2 * segments;
+    int lo = 0, hi = segments - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (hl_u16(ends + 2 * mid) < codepoint) lo = mid + 1;
+        else hi = mid;
+    }
+    if (codepoint < hl_u16(starts + 2 * lo) || codepoint > hl_u16(ends + 2 * lo)) return 0;
+    int range = hl_u16(ranges + 2 * lo);
+    if (range == 0) return (codepoint + hl_s16(deltas + 2 * lo)) & 0xFFFF;
+    uint32_t at = ranges + 2 * lo + range + 2 * (codepoint - hl_u16(starts + 2 * lo));
+    int glyph = hl_u16(at);
+    return glyph ? (glyph + hl_s16(deltas + 2 * lo)) & 0xFFFF : 0;
+}
+
+static int hl_glyph_advance_units(int glyph) {
+    if (glyph >= hl.num_hmetrics) glyph = hl.num_hmetrics - 1;
+    return hl_u16(hl.hmtx + 4 * glyph);
+}
+
+static uint32_t hl_glyph_offset(int glyph, uint32_t *length) {
+    uint32_t start, end;
+    if (glyph >= hl.num_glyphs) {
+        *length = 0;
+        return 0;
+    }
+    if (hl.loca_long) {
+        start = hl_u32(hl.loca + 4 * glyph);
+        end = hl_u32(hl.loca + 4 * glyph + 4);
+    } else {
+        start = hl_u16(hl.loca + 2 * glyph) * 2;
+        end = hl_u16(hl.loca + 2 * glyph + 2) * 2;
+    }
+    *length = end - start;
+    return hl.glyf + start;
+}
+
+// Flattened outline edges in pixel space (y down)
+typedef struct {
+    float x0, y0, x1, y1;
+    int dir;
+} hl_edge;
+
+typedef struct {
+    hl_edge *edges;
+    int count;
+    int capacity;
+} hl_edge_list;
+
+static void hl_edge_add(hl_edge_list *list, float x0, float y0, float x1, float y1) {
+    if (y0 == y1) return;  // horizontal edges never cross a scanline
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 128;
+        list->edges = realloc(list->edges, list->capacity * sizeof(hl_edge));
+    }
+    hl_edge *e = &list->edges[list->count++];
+    if (y0 < y1) *e = (hl_edge){ x0, y0, x1, y1, 1 };
+    else *e = (hl_edge){ x1, y1, x0, y0, -1 };
+}
+
+static void hl_edge_quad(hl_edge_list *list, float x0, float y0, float cx, float cy, float x1, float y1) {
+    const int steps = 8;
+    float px = x0, py = y0;
+    for (int i = 1; i <= steps; i++) {
+        float t = (float)i / steps, u = 1 - t;
+        float x = u * u * x0 + 2 * u * t * cx + t * t * x1;
+        float y = u * u * y0 + 2 * u * t * cy + t * t * y1;
+        hl_edge_add(list, px, py, x, y);
+        px = x;
+        py = y;
+    }
+}
+
+// Append the outline of `glyph`, transformed by the 2x3 matrix m (font units -> pixels)
+static void hl_glyph_outline(hl_edge_list *list, int glyph, const float m[6], int depth) {
+    uint32_t length;
+    uint32_t at = hl_glyph_offset(glyph, &length);
+    if (length == 0 || depth > 4) return;
+    int contours = hl_s16(at);
+
+    if (contours < 0) {
+        // Composite glyph: a list of transformed component glyphs
+        uint32_t p = at + 10;
+        uint16_t flags;
+        do {
+            flags = hl_u16(p);
+            int component = hl_u16(p + 2);
+            p += 4;
+            float dx, dy;
+            if (flags & 0x0001) {
+                dx = hl_s16(p);
+                dy = hl_s16(p + 2);
+                p += 4;
+            } else {
+                dx = (int8_t)hl.font[p];
+                dy = (int8_t)hl.font[p + 1];
+                p += 2;
+            }
+            if (!(flags & 0x0002)) dx = dy = 0;  // point-matched placement is not supported
+            float a = 1, b = 0, c = 0, d = 1;
+            if (flags & 0x0008) {
+                a = d = hl_s16(p) / 16384.0f;
+                p += 2;
+            } else if (flags & 0x0040) {
+                a = hl_s16(p) / 16384.0f;
+                d = hl_s16(p + 2) / 16384.0f;
+                p += 4;
+            } else if (flags & 0x0080) {
+                a = hl_s16(p) / 16384.0f;
+                b = hl_s16(p + 2) / 16384.0f;
+                c = hl_s16(p + 4) / 16384.0f;
+                d = hl_s16(p + 6) / 16384.0f;
+                p += 8;
+            }
+            float child[6] = {
+                m[0] * a + m[2] * b, m[1] * a + m[3] * b,
+                m[0] * c + m[2] * d, m[1] * c + m[3] * d,
+                m[0] * dx + m[2] * dy + m[4], m[1] * dx + m[3] * dy + m[5]
+            };
+            hl_glyph_outline(list, component, child, depth + 1);
+        } while (flags & 0x0020);
+        return;
+    }
+
+    uint32_t end_points = at + 10;
+    int point_count = contours ? hl_u16(end_points + 2 * (contours - 1)) + 1 : 0;
+    uint32_t p = end_points + 2 * contours;
+    p += 2 + hl_u16(p);  // skip instructions
+
+    uint8_t *flags = malloc(point_count);
+    float *xs = malloc(point_count * sizeof(float));
+    float *ys = malloc(point_count * sizeof(float));
+    for (int i = 0; i < point_count;) {
+        uint8_t flag = hl.font[p++];
+        int repeat = (flag & 8) ? hl.font[p++] : 0;
+        for (int r = 0; r <= repeat && i < point_count; r++) flags[i++] = flag;
+    }
+    int value = 0;
+    for (int i = 0; i < point_count; i++) {
+        if (flags[i] & 2) {
+            value += (flags[i] & 16) ? hl.font[p] : -hl.font[p];
+            p++;
+        } else if (!(flags[i] & 16)) {
+            value += hl_s16(p);
+            p += 2;
+        }
+        xs[i] = value;
+    }
+    value = 0;
+    for (int i = 0; i < point_count; i++) {
+        if (flags[i] & 4) {
+            value += (flags[i] & 32) ? hl.font[p] : -hl.font[p];
+            p++;
+        } else if (!(flags[i] & 32)) {
+            value += hl_s16(p);
+            p += 2;
+        }
+        ys[i] = value;
+    }
+    for (int i = 0; i < point_count; i++) {
+        float x = xs[i], y = ys[i];
+        xs[i] = m[0] * x + m[2] * y + m[4];
+        ys[i] = m[1] * x + m[3] * y + m[5];
+    }
+
+    int first = 0;
+    for (int c = 0; c < contours; c++) {
+        int last = hl_u16(end_points + 2 * c);
+        int n = last - first + 1;
+        if (n < 2) {
+            first = last + 1;
+            continue;
+        }
+        // Start from an on-curve point, or the midpoint of two off-curve ones
+        float sx, sy;
+        int start = -1;
+        for (int i = 0; i < n; i++) {
+            if (flags[first + i] & 1) {
+                start = i;
+                break;
+            }
+        }
+        if (start >= 0) {
+            sx = xs[first + start];
+            sy = ys[first + start];
+        } else {
+            start = 0;
+            sx = (xs[first] + xs[first + 1]) / 2;
+            sy = (ys[first] + ys[first + 1]) / 2;
+        }
+        float px = sx, py = sy;
+        bool has_control = false;
+        float cx = 0, cy = 0;
+        for (int k = 1; k <= n; k++) {
+            int i = first + (start + k) % n;
+            float x = xs[i], y = ys[i];
+            if (flags[i] & 1) {
+                if (has_control) hl_edge_quad(list, px, py, cx, cy, x, y);
+                else hl_edge_add(list, px, py, x, y);
+                px = x;
+                py = y;
+                has_control = false;
+            } else {
+                if (has_control) {
+                    float mx = (cx + x) / 2, my = (cy + y) / 2;
+                    hl_edge_quad(list, px, py, cx, cy, mx, my);
+                    px = mx;
+                    py = my;
+                }
+                cx = x;
+                cy = y;
+                has_control = true;
+            }
+        }
+        if (has_control) hl_edge_quad(list, px, py, cx, cy, sx, sy);
+        else hl_edge_add(list, px, py, sx, sy);
+        first = last + 1;
+    }
+    free(flags);
+    free(xs);
+    free(ys);
+}
+
+static void hl_coverage_span(float *row, int width, float xa, float xb, float weight) {
+    if (xa < 0) xa = 0;
+    if (xb > width) xb = width;
+    if (xb <= xa) return;
+    int ia = (int)xa, ib = (int)xb;
+    if (ia == ib) {
+        row[ia] += (xb - xa) * weight;
+        return;
+    }
+    row[ia] += (ia + 1 - xa) * weight;
+    for (int i = ia + 1; i < ib; i++) row[i] += weight;
+    if (ib < width) row[ib] += (xb - ib) * weight;
+}
+
+// Nonzero-winding scanline fill with 4 sub-scanlines per pixel row
+static void hl_rasterize(const hl_edge_list *list, uint8_t *alpha, int width, int height) {
+    const int samples = 4;
+    float *row = malloc(width * sizeof(float));
+    float *xs = malloc(list->count * sizeof(float));
+    int *dirs = malloc(list->count * sizeof(int));
+    for (int y = 0; y < height; y++) {
+        memset(row, 0, width * sizeof(float));
+        for (int s = 0; s < samples; s++) {
+            float sy = y + (s + 0.5f) / samples;
+            int n = 0;
+            for (int i = 0; i < list->count; i++) {
+                const hl_edge *e = &list->edges[i];
+                if (sy < e->y0 || sy >= e->y1) continue;
+                float x = e->x0 + (sy - e->y0) * (e->x1 - e->x0) / (e->y1 - e->y0);
+                int j = n++;
+                while (j > 0 && xs[j - 1] > x) {
+                    xs[j] = xs[j - 1];
+                    dirs[j] = dirs[j - 1];
+                    j--;
+                }
+                xs[j] = x;
+                dirs[j] = e->dir;
+            }
+            int winding = 0;
+            for (int i = 0; i + 1 < n; i++) {
+                winding += dirs[i];
+                if (winding != 0) hl_coverage_span(row, width, xs[i], xs[i + 1], 1.0f / samples);
+            }
+        }
+        for (int x = 0; x < width; x++) {
+            float c = row[x];
+            alpha[y * width + x] = c >= 1 ? 255 : (uint8_t)(c * 255 + 0.5f);
+        }
+    }
+    free(row);
+    free(xs);
+    free(dirs);
+}
+
+static float hl_font_scale(int size) {
+    return (float)size / (hl.ascender - hl.descender);
+}
+
+static void hl_glyph_render(hl_glyph *out, int codepoint, int size) {
+    memset(out, 0, sizeof(*out));
+    out->loaded = true;
+    int glyph = hl_glyph_index(codepoint);
+    float scale = hl_font_scale(size);
+    uint32_t length;
+    uint32_t at = hl_glyph_offset(glyph, &length);
+    if (length == 0) return;
+    int x0 = (int)floorf(hl_s16(at + 2) * scale);
+    int y0 = (int)floorf(-hl_s16(at + 8) * scale);
+    int x1 = (int)ceilf(hl_s16(at + 6) * scale);
+    int y1 = (int)ceilf(-hl_s16(at + 4) * scale);
+    if (x1 <= x0 || y1 <= y0) return;
+    float m[6] = { scale, 0, 0, -scale, (float)-x0, (float)-y0 };
+    hl_edge_list list = {0};
+    hl_glyph_outline(&list, glyph, m, 0);
+    out->x0 = x0;
+    out->y0 = y0;
+    out->width = x1 - x0;
+    out->height = y1 - y0;
+    out->alpha = calloc(out->width * out->height, 1);
+    hl_rasterize(&list, out->alpha, out->width, out->height);
+    free(list.edges);
+}
+
+static hl_glyph_cache *hl_glyph_cache_for(int size) {
+    for (int i = 0; i < HEADLESS_GLYPH_SIZES; i++) {
+        if (hl.glyph_cache[i].size == size) return &hl.glyph_cache[i];
+    }
+    // Evict round-robin
+    hl_glyph_cache *cache = &hl.glyph_cache[hl.glyph_cache_next];
+    hl.glyph_cache_next = (hl.glyph_cache_next + 1) % HEADLESS_GLYPH_SIZES;
+    for (int i = 0; i < 128; i++) free(cache->glyphs[i].alpha);
+    memset(cache, 0, sizeof(*cache));
+    cache->size = size;
+    return cache;
+}
+
+// Decode one UTF-8 codepoint and advance *text past it
+static int hl_next_codepoint(const char **text) {
+    const unsigned char *s = (const unsigned char *)*text;
+    int cp = s[0], extra = 0;
+    if (cp >= 0xF0) { cp &= 0x07; extra = 3; }
+    else if (cp >= 0xE0) { cp &= 0x0F; extra = 2; }
+    else if (cp >= 0xC0) { cp &= 0x1F; extra = 1; }
+    int i = 1;
+    for (; i <= extra && (s[i] & 0xC0) == 0x80; i++) cp = (cp << 6) | (s[i] & 0x3F);
+    *text += i;
+    return cp;
+}
+
+//--------------------------- Framebuffer ---------------------------
+
+static void hl_blend(uint8_t *dst, Color c, int coverage) {
+    int a = c.a * coverage / 255;
+    if (a == 0) return;
+    if (a == 255) {
+        dst[0] = c.r;
+        dst[1] = c.g;
+        dst[2] = c.b;
+        dst[3] = 255;
+        return;
+    }
+    int inv = 255 - a;
+    dst[0] = (c.r * a + dst[0] * inv) / 255;
+    dst[1] = (c.g * a + dst[1] * inv) / 255;
+    dst[2] = (c.b * a + dst[2] * inv) / 255;
+    dst[3] = a + dst[3] * inv / 255;
+}
+
+// Pixel range [x0,x1) x [y0,y1) of a float rectangle after scissor clipping
+static bool hl_clip(float fx, float fy, float fw, float fh, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = (int)floorf(fx + 0.5f);
+    *y0 = (int)floorf(fy + 0.5f);
+    *x1 = (int)floorf(fx + fw + 0.5f);
+    *y1 = (int)floorf(fy + fh + 0.5f);
+    int cx0 = 0, cy0 = 0, cx1 = hl.target->width, cy1 = hl.target->height;
+    if (hl.scissor) {
+        if (hl.clip.x > cx0) cx0 = hl.clip.x;
+        if (hl.clip.y > cy0) cy0 = hl.clip.y;
+        if (hl.clip.x + hl.clip.width < cx1) cx1 = hl.clip.x + hl.clip.width;
+        if (hl.clip.y + hl.clip.height < cy1) cy1 = hl.clip.y + hl.clip.height;
+    }
+    if (*x0 < cx0) *x0 = cx0;
+    if (*y0 < cy0) *y0 = cy0;
+    if (*x1 > cx1) *x1 = cx1;
+    if (*y1 > cy1) *y1 = cy1;
+    return *x0 < *x1 && *y0 < *y1;
+}
+
+static void hl_fill(float fx, float fy, float fw, float fh, Color c) {
+    int x0, y0, x1, y1;
+    if (!hl_clip(fx, fy, fw, fh, &x0, &y0, &x1, &y1)) return;
+    for (int y = y0; y < y1; y++) {
+        uint8_t *p = hl.target->pixels + ((size_t)y * hl.target->width + x0) * 4;
+        for (int x = x0; x < x1; x++, p += 4) hl_blend(p, c, 255);
+    }
+}
+
+// Coverage of the pixel centred at (px,py) by a disc, with a one pixel soft edge
+static int hl_disc_coverage(float px, float py, float cx, float cy, float r) {
+    float dx = px - cx, dy = py - cy;
+    float d = sqrtf(dx * dx + dy * dy);
+    float c = r + 0.5f - d;
+    if (c <= 0) return 0;
+    if (c >= 1) return 255;
+    return (int)(c * 255);
+}
+
+//--------------------------- raylib drawing API ---------------------------
+
+void ClearBackground(Color color) {
+    // Like glClear, clearing honours the scissor rectangle
+    int x0, y0, x1, y1;
+    if (!hl_clip(0, 0, hl.target->width, hl.target->height, &x0, &y0, &x1, &y1)) return;
+    for (int y = y0; y < y1; y++) {
+        uint8_t *p = hl.target->pixels + ((size_t)y * hl.target->width + x0) * 4;
+        for (int x = x0; x < x1; x++, p += 4) {
+            p[0] = color.r;
+            p[1] = color.g;
+            p[2] = color.b;
+            p[3] = color.a;
+        }
+    }
+}
+
+void DrawRectangle(int posX, int posY, int width, int height, Color color) {
+    hl_fill(posX, posY, width, height, color);
+}
+
+void DrawRectangleRec(Rectangle rec, Color color) {
+    hl_fill(rec.x, rec.y, rec.width, rec.height, color);
+}
+
+void DrawRectangleLines(int posX, int posY, int width, int height, Color color) {
+    hl_fill(posX, posY, width, 1, color);
+    hl_fill(posX, posY + height - 1, width, 1, color);
+    hl_fill(posX, posY + 1, 1, height - 2, color);
+    hl_fill(posX + width - 1, posY + 1, 1, height - 2, color);
+}
+
+void DrawRectangleRounded(Rectangle rec, float roundness, int segments, Color color) {
+    (void)segments;  // corners are exact arcs here
+    float size = rec.width > rec.height ? rec.height : rec.width;
+    float r = size * roundness / 2;
+    if (r <= 0) {
+        hl_fill(rec.x, rec.y, rec.width, rec.height, color);
+        return;
+    }
+    int x0, y0, x1, y1;
+    if (!hl_clip(rec.x, rec.y, rec.width, rec.height, &x0, &y0, &x1, &y1)) return;
+    float left = rec.x + r, right = rec.x + rec.width - r;
+    float top = rec.y + r, bottom = rec.y + rec.height - r;
+    for (int y = y0; y < y1; y++) {
+        float py = y + 0.5f;
+        uint8_t *p = hl.target->pixels + ((size_t)y * hl.target->width + x0) * 4;
+        for (int x = x0; x < x1; x++, p += 4) {
+            float px = x + 0.5f;
+            float cx = px < left ? left : (px > right ? right : px);
+            float cy = py < top ? top : (py > bottom ? bottom : py);
+            int coverage = (cx == px || cy == py) ? 255 : hl_disc_coverage(px, py, cx, cy, r);
+            if (coverage) hl_blend(p, color, coverage);
+        }
+    }
+}
+
+void DrawCircle(int centerX, int centerY, float radius, Color color) {
+    int x0, y0, x1, y1;
+    if (!hl_clip(centerX - radius - 1, centerY - radius - 1, 2 * radius + 2, 2 * radius + 2, &x0, &y0, &x1, &y1)) return;
+    for (int y = y0; y < y1; y++) {
+        uint8_t *p = hl.target->pixels + ((size_t)y * hl.target->width + x0) * 4;
+        for (int x = x0; x < x1; x++, p += 4) {
+            int coverage = hl_disc_coverage(x + 0.5f, y + 0.5f, centerX, centerY, radius);
+            if (coverage) hl_blend(p, color, coverage);
+        }
+    }
+}
+
+static void hl_draw_glyph(const hl_glyph *g, int x, int y, Color color) {
+    if (g->alpha == NULL) return;
+    int x0, y0, x1, y1;
+    if (!hl_clip(x + g->x0, y + g->y0, g->width, g->height, &x0, &y0, &x1, &y1)) return;
+    for (int py = y0; py < y1; py++) {
+        const uint8_t *src = g->alpha + (py - y - g->y0) * g->width + (x0 - x - g->x0);
+        uint8_t *p = hl.target->pixels + ((size_t)py * hl.target->width + x0) * 4;
+        for (int px = x0; px < x1; px++, p += 4, src++) {
+            if (*src) hl_blend(p, color, *src);
+        }
+    }
+}
+
+// Advance of a codepoint in font units, and the size in pixels of a font unit
+// at `size`. MeasureText is the widest line's sum of advances times the
+// scale, which rl.h's text metrics cache relies on to measure incrementally.
+float headless_glyph_units(int codepoint) {
+    if (hl.font == NULL) return 0.6f;
+    return hl_glyph_advance_units(hl_glyph_index(codepoint));
+}
+
+float headless_unit_scale(int size) {
+    if (hl.font == NULL) return size;
+    return hl_font_scale(size);
+}
+
+// Advance of one codepoint at `size` pixels, without inter-glyph spacing
+static float hl_advance(int codepoint, int size) {
+    return headless_glyph_units(codepoint) * headless_unit_scale(size);
+}
+
+void DrawText(const char *text, int posX, int posY, int fontSize, Color color) {
+    if (hl.font == NULL || text == NULL) return;
+    hl_glyph_cache *cache = hl_glyph_cache_for(fontSize);
+    int baseline = posY + (int)(hl.ascender * hl_font_scale(fontSize) + 0.5f);
+    float pen = posX;
+    while (*text) {
+        if (*text == '\n') {
+            baseline += fontSize + 2;  // raylib's default text line spacing
+            pen = posX;
+            text++;
+            continue;
+        }
+        int cp = hl_next_codepoint(&text);
+        int x = (int)floorf(pen + 0.5f);
+        if (cp < 128) {
+            hl_glyph *g = &cache->glyphs[cp];
+            if (!g->loaded) hl_glyph_render(g, cp, fontSize);
+            hl_draw_glyph(g, x, baseline, color);
+        } else {
+            hl_glyph g;
+            hl_glyph_render(&g, cp, fontSize);
+            hl_draw_glyph(&g, x, baseline, color);
+            free(g.alpha);
+        }
+        pen += hl_advance(cp, fontSize);
+    }
+}
+
+// Width of the widest line of `text`, like raylib's MeasureText
+int MeasureText(const char *text, int fontSize) {
+    if (text == NULL) return 0;
+    float width = 0, line = 0;  // in font units
+    while (*text) {
+        if (*text == '\n') {
+            if (line > width) width = line;
+            line = 0;
+            text++;
+            continue;
+        }
+        line += headless_glyph_units(hl_next_codepoint(&text));
+    }
+    if (line > width) width = line;
+    return (int)(width * headless_unit_scale(fontSize));
+}
+
+// Decode the UTF-8 codepoint at `text`, like raylib's GetCodepointNext
+int GetCodepointNext(const char *text, int *codepointSize) {
+    const char *next = text;
+    int codepoint = hl_next_codepoint(&next);
+    *codepointSize = (int)(next - text);
+    return codepoint;
+}
+
+// Draw `source` of a texture with its top-left corner at `position`. Render
+// textures are addressed bottom-up and drawn with a negative source height,
+// as with OpenGL in raylib, so the same rectangles work with both backends.
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint) {
+    if (texture.id == 0 || texture.id > HEADLESS_MAX_TEXTURES) return;
+    const hl_target *src = &hl.textures[texture.id - 1];
+    if (src->pixels == NULL) return;
+    bool flip = source.height < 0;
+    int width = (int)source.width, height = (int)fabsf(source.height);
+    int x0, y0, x1, y1;
+    if (!hl_clip(position.x, position.y, width, height, &x0, &y0, &x1, &y1)) return;
+    int ox = (int)floorf(position.x + 0.5f), oy = (int)floorf(position.y + 0.5f);
+    for (int y = y0; y < y1; y++) {
+        // Row `y - oy` of the drawn image, counted from the top
+        int row = flip ? src->height - (int)source.y - height + (y - oy) : src->height - 1 - (int)source.y - (y - oy);
+        if (row < 0 || row >= src->height) continue;
+        int first = x0, last = x1;
+        if ((int)source.x + (first - ox) < 0) first = ox - (int)source.x;
+        if ((int)source.x + (last - ox) > src->width) last = ox - (int)source.x + src->width;
+        uint8_t *p = hl.target->pixels + ((size_t)y * hl.target->width + first) * 4;
+        const uint8_t *t = src->pixels + ((size_t)row * src->width + (int)source.x + (first - ox)) * 4;
+        bool untinted = tint.r == 255 && tint.g == 255 && tint.b == 255 && tint.a == 255;
+        for (int x = first; x < last; x++, p += 4, t += 4) {
+            if (untinted && t[3] == 255) {
+                memcpy(p, t, 4);  // opaque texel, the common case for cached widgets
+                continue;
+            }
+            Color c = { t[0] * tint.r / 255, t[1] * tint.g / 255, t[2] * tint.b / 255, t[3] * tint.a / 255 };
+            hl_blend(p, c, 255);
+        }
+    }
+}
+
+void BeginScissorMode(int x, int y, int width, int height) {
+    hl.scissor = true;
+    hl.clip = (Rectangle){ x, y, width, height };
+}
+
+void EndScissorMode(void) {
+    hl.scissor = false;
+}
+
+//--------------------------- raylib render texture API ---------------------------
+
+RenderTexture2D LoadRenderTexture(int width, int height) {
+    RenderTexture2D target = {0};
+    for (int i = 0; i < HEADLESS_MAX_TEXTURES; i++) {
+        if (hl.textures[i].pixels != NULL) continue;
+        hl.textures[i].pixels = calloc((size_t)width * height, 4);
+        hl.textures[i].width = width;
+        hl.textures[i].height = height;
+        target.id = i + 1;
+        target.texture = (Texture){ i + 1, width, height, 1, 7 };  // 7 = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        return target;
+    }
+    TraceLog(LOG_WARNING, "HEADLESS: too many render textures");
+    return target;
+}
+
+void UnloadRenderTexture(RenderTexture2D target) {
+    if (target.id == 0 || target.id > HEADLESS_MAX_TEXTURES) return;
+    hl_target *texture = &hl.textures[target.id - 1];
+    if (hl.target == texture) hl.target = &hl.screen;
+    free(texture->pixels);
+    *texture = (hl_target){0};
+}
+
+void BeginTextureMode(RenderTexture2D target) {
+    if (target.id == 0 || target.id > HEADLESS_MAX_TEXTURES || hl.textures[target.id - 1].pixels == NULL) return;
+    hl.target = &hl.textures[target.id - 1];
+    hl.scissor = false;
+}
+
+void EndTextureMode(void) {
+    hl.target = &hl.screen;
+    hl.scissor = false;
+}
+
+//--------------------------- raylib input API ---------------------------
+
+Vector2 GetMousePosition(void) {
+    return hl.mouse;
+}
+
+bool IsMouseButtonPressed(int button) {
+    return button >= 0 && button < HEADLESS_MAX_MOUSE_BUTTONS && hl.mouse_down[button] && !hl.mouse_prev[button];
+}
+
+bool IsMouseButtonDown(int button) {
+    return button >= 0 && button < HEADLESS_MAX_MOUSE_BUTTONS && hl.mouse_down[button];
+}
+
+bool IsMouseButtonReleased(int button) {
+    return button >= 0 && button < HEADLESS_MAX_MOUSE_BUTTONS && !hl.mouse_down[button] && hl.mouse_prev[button];
+}
+
+bool IsMouseButtonUp(int button) {
+    return !IsMouseButtonDown(button);
+}
+
+float GetMouseWheelMove(void) {
+    return hl.wheel;
+}
+
+bool IsKeyPressed(int key) {
+    return key > 0 && key < HEADLESS_MAX_KEYS && hl.key_down[key] && !hl.key_prev[key];
+}
+
+bool IsKeyDown(int key) {
+    return key > 0 && key < HEADLESS_MAX_KEYS && hl.key_down[key];
+}
+
+bool IsKeyReleased(int key) {
+    return key > 0 && key < HEADLESS_MAX_KEYS && !hl.key_down[key] && hl.key_prev[key];
+}
+
+bool IsKeyUp(int key) {
+    return !IsKeyDown(key);
+}
+
+int GetKeyPressed(void) {
+    if (hl.key_queue_count == 0) return 0;
+    int key = hl.key_queue[0];
+    memmove(hl.key_queue, hl.key_queue + 1, --hl.key_queue_count * sizeof(int));
+    return key;
+}
+
+int GetCharPressed(void) {
+    if (hl.char_queue_count == 0) return 0;
+    int ch = hl.char_queue[0];
+    memmove(hl.char_queue, hl.char_queue + 1, --hl.char_queue_count * sizeof(int));
+    return ch;
+}
+
+// Queue events of the frame that is about to start; called from EndDrawing like raylib's PollInputEvents
+static void hl_poll_input(void) {
+    memcpy(hl.mouse_prev, hl.mouse_down, sizeof(hl.mouse_down));
+    memcpy(hl.key_prev, hl.key_down, sizeof(hl.key_down));
+    hl.wheel = 0;
+    hl.key_queue_count = 0;
+    hl.char_queue_count = 0;
+    hl.key_event_count = 0;
+    while (hl.script_next < hl.script_count && hl.script[hl.script_next].frame <= hl.frame) {
+        const headless_event *e = &hl.script[hl.script_next++];
+        bool keyboard = e->type == HEADLESS_EVENT_KEY_DOWN || e->type == HEADLESS_EVENT_KEY_UP || e->type == HEADLESS_EVENT_CHAR;
+        if (keyboard && hl.key_event_count < HEADLESS_MAX_KEY_EVENTS) hl.key_events[hl.key_event_count++] = *e;
+        switch (e->type) {
+            case HEADLESS_EVENT_MOUSE_MOVE:
+                hl.mouse = (Vector2){ e->x, e->y };
+                break;
+            case HEADLESS_EVENT_MOUSE_DOWN:
+            case HEADLESS_EVENT_MOUSE_UP:
+                if (e->value >= 0 && e->value < HEADLESS_MAX_MOUSE_BUTTONS) hl.mouse_down[e->value] = (e->type == HEADLESS_EVENT_MOUSE_DOWN);
+                break;
+            case HEADLESS_EVENT_WHEEL:
+                hl.wheel += e->x;
+                break;
+            case HEADLESS_EVENT_KEY_DOWN:
+                if (e->value > 0 && e->value < HEADLESS_MAX_KEYS) {
+                    hl.key_down[e->value] = true;
+                    if (hl.key_queue_count < HEADLESS_QUEUE_SIZE) hl.key_queue[hl.key_queue_count++] = e->value;
+                }
+                break;
+            case HEADLESS_EVENT_KEY_UP:
+                if (e->value > 0 && e->value < HEADLESS_MAX_KEYS) hl.key_down[e->value] = false;
+                break;
+            case HEADLESS_EVENT_CHAR:
+                if (hl.char_queue_count < HEADLESS_QUEUE_SIZE) hl.char_queue[hl.char_queue_count++] = e->value;
+                break;
+            case HEADLESS_EVENT_QUIT:
+                hl.quit = true;
+                break;
+        }
+    }
+}
+
+//--------------------------- Scripting API ---------------------------
+
+// Use `events` (sorted by frame, not copied) as the input source
+void headless_set_script(const headless_event *events, int count) {
+    if (hl.script_owned) free(hl.script);
+    hl.script = (headless_event *)events;
+    hl.script_count = count;
+    hl.script_next = 0;
+    hl.script_owned = false;
+}
+
+// The frame's key_down, key_up and char events in script order, which the
+// 16-entry raylib queues would cut short; returns how many, once per frame
+int headless_take_key_events(const headless_event **events) {
+    int count = hl.key_event_count;
+    *events = hl.key_events;
+    hl.key_event_count = 0;
+    return count;
+}
+
+// Make WindowShouldClose() return true once `frames` frames have been presented (0 = never)
+void headless_set_frame_limit(int frames) {
+    hl.frame_limit = frames;
+}
+
+static bool hl_parse_event(const char *line, headless_event *e) {
+    char name[16];
+    int consumed = 0;
+    memset(e, 0, sizeof(*e));
+    if (sscanf(line, "%d %15s %n", &e->frame, name, &consumed) < 2) return false;
+    const char *args = line + consumed;
+    if (strcmp(name, "move") == 0) {
+        e->type = HEADLESS_EVENT_MOUSE_MOVE;
+        return sscanf(args, "%f %f", &e->x, &e->y) == 2;
+    }
+    if (strcmp(name, "down") == 0 || strcmp(name, "up") == 0) {
+        e->type = name[0] == 'd' ? HEADLESS_EVENT_MOUSE_DOWN : HEADLESS_EVENT_MOUSE_UP;
+        return sscanf(args, "%d", &e->value) == 1;
+    }
+    if (strcmp(name, "wheel") == 0) {
+        e->type = HEADLESS_EVENT_WHEEL;
+        return sscanf(args, "%f", &e->x) == 1;
+    }
+    if (strcmp(name, "key_down") == 0 || strcmp(name, "key_up") == 0) {
+        e->type = name[4] == 'd' ? HEADLESS_EVENT_KEY_DOWN : HEADLESS_EVENT_KEY_UP;
+        return sscanf(args, "%d", &e->value) == 1;
+    }
+    if (strcmp(name, "char") == 0) {
+        e->type = HEADLESS_EVENT_CHAR;
+        if (args[0] != '\0' && (args[1] == '\0' || args[1] == '\n')) e->value = (unsigned char)args[0];
+        else if (sscanf(args, "%d", &e->value) != 1) return false;
+        return true;
+    }
+    if (strcmp(name, "quit") == 0) {
+        e->type = HEADLESS_EVENT_QUIT;
+        return true;
+    }
+    return false;
+}
+
+// Load a script in the RUI_HEADLESS_SCRIPT text format
+bool headless_load_script(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return false;
+    headless_event *events = NULL;
+    int count = 0, capacity = 0, line_number = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        headless_event e;
+        if (!hl_parse_event(line, &e)) {
+            TraceLog(LOG_WARNING, "HEADLESS: %s:%d: cannot parse event", path, line_number);
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            events = realloc(events, capacity * sizeof(headless_event));
+        }
+        // Keep the list sorted by frame (stable for events of the same frame)
+        int i = count++;
+        while (i > 0 && events[i - 1].frame > e.frame) {
+            events[i] = events[i - 1];
+            i--;
+        }
+        events[i] = e;
+    }
+    fclose(file);
+    headless_set_script(events, count);
+    hl.script_owned = true;
+    return true;
+}
+
+// Framebuffer of the last presented frame, RGBA8 top row first
+const uint8_t *headless_get_framebuffer(int *width, int *height) {
+    if (width) *width = hl.screen.width;
+    if (height) *height = hl.screen.height;
+    return hl.screen.pixels;
+}
+
+// Write the framebuffer as a binary PPM, for eyeballing CI output
+bool headless_save_ppm(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+    fprintf(file, "P6\n%d %d\n255\n", hl.screen.width, hl.screen.height);
+    for (int i = 0; i < hl.screen.width * hl.screen.height; i++) fwrite(hl.screen.pixels + i * 4, 1, 3, file);
+    fclose(file);
+    return true;
+}
+
+long headless_frame_count(void) {
+    return hl.frame;
+}
+
+//--------------------------- raylib window / timing API ---------------------------
+
+void InitWindow(int width, int height, const char *title) {
+    (void)title;
+    hl.screen.width = width;
+    hl.screen.height = height;
+    hl.screen.pixels = calloc((size_t)width * height, 4);
+    hl.target = &hl.screen;
+    hl.start_time = hl_now();
+    hl.frame_start = hl.start_time;
+
+    const char *font = getenv("RUI_FONT");
+    if (font == NULL) font = RUI_FONT_PATH;
+    if (!hl_font_load(font)) TraceLog(LOG_WARNING, "HEADLESS: could not load font %s, text will not be drawn", font);
+
+    const char *frames = getenv("RUI_HEADLESS_FRAMES");
+    if (frames) hl.frame_limit = atoi(frames);
+    const char *script = getenv("RUI_HEADLESS_SCRIPT");
+    if (script && !headless_load_script(script)) TraceLog(LOG_WARNING, "HEADLESS: could not load script %s", script);
+    hl_poll_input();  // events of frame 0
+}
+
+void CloseWindow(void) {
+    double elapsed = hl_now() - hl.start_time;
+    TraceLog(LOG_INFO, "HEADLESS: %ld frames in %.3f s (%.1f fps)", hl.frame, elapsed, elapsed > 0 ? hl.frame / elapsed : 0.0);
+    for (int i = 0; i < HEADLESS_GLYPH_SIZES; i++) {
+        for (int g = 0; g < 128; g++) free(hl.glyph_cache[i].glyphs[g].alpha);
+    }
+    if (hl.script_owned) free(hl.script);
+    free(hl.screen.pixels);
+    for (int i = 0; i < HEADLESS_MAX_TEXTURES; i++) free(hl.textures[i].pixels);
+    free(hl.font);
+    memset(&hl, 0, sizeof(hl));
+}
+
+bool WindowShouldClose(void) {
+    if (hl.quit) return true;
+    return hl.frame_limit > 0 && hl.frame >= hl.frame_limit;
+}
+
+// Frames run as fast as the CPU allows; the target is ignored
+void SetTargetFPS(int fps) {
+    (void)fps;
+}
+
+int GetScreenWidth(void) {
+    return hl.screen.width;
+}
+
+int GetScreenHeight(void) {
+    return hl.screen.height;
+}
+
+// The framebuffer size is fixed at InitWindow()
+bool IsWindowResized(void) {
+    return false;
+}
+
+double GetTime(void) {
+    return hl_now() - hl.start_time;
+}
+
+float GetFrameTime(void) {
+    return hl.frame_time;
+}
+
+int GetFPS(void) {
+    return hl.frame_time > 0 ? (int)(1.0f / hl.frame_time + 0.5f) : 0;
+}
+
+void WaitTime(double seconds) {
+    if (seconds <= 0) return;
+    struct timespec ts = { (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+void BeginDrawing(void) {
+}
+
+void EndDrawing(void) {
+    hl.scissor = false;
+    double now = hl_now();
+    hl.frame_time = (float)(now - hl.frame_start);
+    hl.frame_start = now;
+    hl.frame++;
+    hl_poll_input();
+}
@@ -1,12 +1,11 @@
 #include<stdint.h>
 #include<stdbool.h>
-#include"raylib.h"
 #include"rl.h"
 #include<string.h>
+#include<stdio.h>
+#include<stdarg.h>
 
-#define MAX_LINES 10           // for text boxes
-#define MAX_LINE_LENGTH 128    // for text boxes
-#define MAX_TEXT_LENGTH 256    // for text entry
+#define MAX_TEXT_LENGTH 65536  // for text entry
 
 //--------------------------- Style Struct ---------------------------
 
@@ -37,6 +36,850 @@ Rectangle toRaylibRectangle(rui_rect rect) {
     Rectangle raylibRect = { rect.x, rect.y, rect.width, rect.height };
     return raylibRect;
 }
+
+// Damage both the old and the new area of a widget that moved or resized
+static void rui_damage_move(Rectangle old_area, Rectangle new_area) {
+    if (old_area.x == new_area.x && old_area.y == new_area.y &&
+        old_area.width == new_area.width && old_area.height == new_area.height) return;
+    damage_rect(old_area);
+    damage_rect(new_area);
+}
+
+//--------------------------- Input ---------------------------
+// Input of one frame, read from the backend once by poll_input and passed to
+// every update_* function. Widgets only read it, so two text widgets see the
+// same typed characters, and tests can fill one in by hand.
+//
+// Besides the keys pressed and characters typed, the input carries the
+// frame's keyboard events in the order they happened: key downs, ups,
+// auto-repeats and characters, each with its time. Text widgets apply them in
+// one pass, so a burst of keystrokes within one frame is neither dropped nor
+// spread over several frames, and a held Backspace repeats at
+// RUI_KEY_REPEAT_INTERVAL whatever the frame rate. The events come from
+// take_key_events, with the times the keys went down and up; only when the
+// backend cannot report them are they rebuilt from raylib's queues, which
+// keep 16 presses and 16 characters a frame, all stamped with the frame time.
+
+#define RUI_MAX_INPUT_KEYS 64
+#define RUI_MAX_INPUT_CHARS 64
+#define RUI_MAX_INPUT_EVENTS 256
+#define RUI_MAX_HELD_KEYS 16
+#define RUI_KEY_REPEAT_DELAY 0.5           // seconds a key is held before it repeats
+#define RUI_KEY_REPEAT_INTERVAL (1.0 / 30)
+
+typedef enum {
+    RUI_KEY_DOWN,
+    RUI_KEY_UP,
+    RUI_KEY_REPEAT,
+    RUI_KEY_CHAR
+} rui_key_event_type;
+
+typedef struct {
+    double time;              // Same clock as rui_input.time; repeats fall between frames
+    int code;                 // Key, or the codepoint of a RUI_KEY_CHAR
+    uint8_t type;             // rui_key_event_type
+} rui_key_event;
+
+typedef struct {
+    double time;              // GetTime() when the frame started; animations use it instead of the clock
+    float dt;                 // Duration of the previous frame
+    Vector2 mouse;
+    bool mouse_down[3];       // Indexed by MOUSE_BUTTON_LEFT, _RIGHT, _MIDDLE
+    bool mouse_pressed[3];
+    bool mouse_released[3];
+    float wheel;
+    bool shift;                       // A shift key is held
+    int keys[RUI_MAX_INPUT_KEYS];     // Keys pressed this frame, in order
+    int key_count;
+    int chars[RUI_MAX_INPUT_CHARS];   // Characters typed this frame, in order
+    int char_count;
+    rui_key_event events[RUI_MAX_INPUT_EVENTS];  // Keyboard events since the last frame, in order
+    int event_count;
+} rui_input;
+
+static void rui_push_key_event(rui_input *input, rui_key_event_type type, int code, double time) {
+    if (input->event_count < RUI_MAX_INPUT_EVENTS) input->events[input->event_count++] = (rui_key_event){ time, code, type };
+}
+
+// Cursor blink phase shared by text widgets: visible for the first half of every 0.5 s
+static bool rui_cursor_blink_on(const rui_input *input) {
+    return (input->time * 2.0f) - (int)(input->time * 2.0f) < 0.5f;
+}
+
+// In on-demand pacing, wake up for the next blink toggle (every 0.25 s)
+static void rui_request_blink_frame(const rui_input *input) {
+    double t = input->time * 4.0;
+    request_frame_in(((int)t + 1 - t) / 4.0);
+}
+
+//--------------------------- Input Recording ---------------------------
+// poll_input can append every snapshot to a binary log, or read snapshots back
+// from one instead of the backend, so a session replays as a benchmark with
+// no display. init_ui starts either from the environment:
+//   RUI_RECORD_INPUT=<file>   record the session
+//   RUI_REPLAY_INPUT=<file>   replay it as fast as possible and log each frame's update and draw time
+//   RUI_REPLAY_REALTIME=1     replay at the recorded frame times instead
+// A log is a header (magic, version) and one record per frame in host byte order:
+// time (double), dt, mouse x, mouse y, wheel (floats), mouse button bits (uint16:
+// down, pressed, released, 3 bits each, then shift held), key and char counts
+// (uint8 each), the keys (int16 each), the chars (int32 each), and the key
+// events: their count (uint16), times (double each), codes (int32 each) and
+// types (uint8 each). Version 1 logs lack the shift bit and, like version 2,
+// the events, which are made up from the keys and chars when they replay.
+
+#define RUI_INPUT_LOG_MAGIC 0x4c495552u  // "RUIL"
+#define RUI_INPUT_LOG_VERSION 3u
+
+static struct {
+    FILE *record;
+    FILE *replay;
+    bool realtime;
+    uint32_t version;       // Of the replayed log
+    bool finished;          // The replayed log ran out
+    long frames;            // Frames replayed so far
+    double poll_time;       // GetTime() when the last replayed frame was polled
+    double recorded_time;   // Its recorded time
+    double update_total, update_max;
+    double draw_total, draw_max;
+} rui_input_log = {0};
+
+static void rui_input_log_write(FILE *file, const rui_input *input) {
+    float values[4] = { input->dt, input->mouse.x, input->mouse.y, input->wheel };
+    uint16_t buttons = 0;
+    for (int button = 0; button < 3; button++) {
+        buttons |= input->mouse_down[button] << button | input->mouse_pressed[button] << (button + 3) | input->mouse_released[button] << (button + 6);
+    }
+    buttons |= input->shift << 9;
+    uint8_t counts[2] = { input->key_count, input->char_count };
+    int16_t keys[RUI_MAX_INPUT_KEYS];
+    int32_t chars[RUI_MAX_INPUT_CHARS];
+    for (int i = 0; i < input->key_count; i++) keys[i] = input->keys[i];
+    for (int i = 0; i < input->char_count; i++) chars[i] = input->chars[i];
+    fwrite(&input->time, sizeof(double), 1, file);
+    fwrite(values, sizeof(float), 4, file);
+    fwrite(&buttons, sizeof(buttons), 1, file);
+    fwrite(counts, 1, 2, file);
+    fwrite(keys, sizeof(int16_t), input->key_count, file);
+    fwrite(chars, sizeof(int32_t), input->char_count, file);
+    uint16_t event_count = input->event_count;
+    double times[RUI_MAX_INPUT_EVENTS];
+    int32_t codes[RUI_MAX_INPUT_EVENTS];
+    uint8_t types[RUI_MAX_INPUT_EVENTS];
+    for (int i = 0; i < input->event_count; i++) {
+        times[i] = input->events[i].time;
+        codes[i] = input->events[i].code;
+        types[i] = input->events[i].type;
+    }
+    fwrite(&event_count, sizeof(event_count), 1, file);
+    fwrite(times, sizeof(double), event_count, file);
+    fwrite(codes, sizeof(int32_t), event_count, file);
+    fwrite(types, 1, event_count, file);
+}
+
+// False at the end of the log or on a damaged record
+static bool rui_input_log_read(FILE *file, rui_input *input) {
+    float values[4];
+    uint16_t buttons;
+    uint8_t counts[2];
+    int16_t keys[RUI_MAX_INPUT_KEYS];
+    int32_t chars[RUI_MAX_INPUT_CHARS];
+    if (fread(&input->time, sizeof(double), 1, file) != 1 || fread(values, sizeof(float), 4, file) != 4 ||
+        fread(&buttons, sizeof(buttons), 1, file) != 1 || fread(counts, 1, 2, file) != 2) return false;
+    if (counts[0] > RUI_MAX_INPUT_KEYS || counts[1] > RUI_MAX_INPUT_CHARS) return false;
+    if (fread(keys, sizeof(int16_t), counts[0], file) != counts[0] || fread(chars, sizeof(int32_t), counts[1], file) != counts[1]) return false;
+    input->dt = values[0];
+    input->mouse = (Vector2){ values[1], values[2] };
+    input->wheel = values[3];
+    for (int button = 0; button < 3; button++) {
+        input->mouse_down[button] = buttons >> button & 1;
+        input->mouse_pressed[button] = buttons >> (button + 3) & 1;
+        input->mouse_released[button] = buttons >> (button + 6) & 1;
+    }
+    input->shift = buttons >> 9 & 1;
+    input->key_count = counts[0];
+    input->char_count = counts[1];
+    for (int i = 0; i < input->key_count; i++) input->keys[i] = keys[i];
+    for (int i = 0; i < input->char_count; i++) input->chars[i] = chars[i];
+
+    input->event_count = 0;
+    if (rui_input_log.version < 3) {
+        for (int i = 0; i < input->key_count; i++) rui_push_key_event(input, RUI_KEY_DOWN, input->keys[i], input->time);
+        for (int i = 0; i < input->char_count; i++) rui_push_key_event(input, RUI_KEY_CHAR, input->chars[i], input->time);
+        return true;
+    }
+    uint16_t event_count;
+    double times[RUI_MAX_INPUT_EVENTS];
+    int32_t codes[RUI_MAX_INPUT_EVENTS];
+    uint8_t types[RUI_MAX_INPUT_EVENTS];
+    if (fread(&event_count, sizeof(event_count), 1, file) != 1 || event_count > RUI_MAX_INPUT_EVENTS) return false;
+    if (fread(times, sizeof(double), event_count, file) != event_count || fread(codes, sizeof(int32_t), event_count, file) != event_count ||
+        fread(types, 1, event_count, file) != event_count) return false;
+    for (int i = 0; i < event_count; i++) rui_push_key_event(input, types[i], codes[i], times[i]);
+    return true;
+}
+
+// Log the timings of the frame that was replayed last, now that it has been drawn
+static void rui_input_log_frame_done(void) {
+    rl_draw_stats stats = get_draw_stats();
+    double update = stats.begin_time - rui_input_log.poll_time;
+    double draw = stats.draw_seconds;
+    rui_input_log.update_total += update;
+    rui_input_log.draw_total += draw;
+    if (update > rui_input_log.update_max) rui_input_log.update_max = update;
+    if (draw > rui_input_log.draw_max) rui_input_log.draw_max = draw;
+    TraceLog(LOG_INFO, "RUI: replay frame %ld: update %.3f ms, draw %.3f ms%s", rui_input_log.frames - 1,
+             update * 1000, draw * 1000, stats.presented ? "" : " (dropped)");
+}
+
+// Next snapshot of the replayed log, or an empty one once it has run out
+static rui_input rui_input_log_next(void) {
+    rui_input input = {0};
+    if (rui_input_log.frames > 0) rui_input_log_frame_done();
+    if (!rui_input_log_read(rui_input_log.replay, &input)) {
+        input = (rui_input){0};
+        input.time = rui_input_log.recorded_time;
+        rui_input_log.finished = true;
+        return input;
+    }
+    if (rui_input_log.realtime && rui_input_log.frames > 0) {
+        double wait = (input.time - rui_input_log.recorded_time) - (GetTime() - rui_input_log.poll_time);
+        if (wait > 0) WaitTime(wait);
+    }
+    rui_input_log.recorded_time = input.time;
+    rui_input_log.poll_time = GetTime();
+    rui_input_log.frames++;
+    return input;
+}
+
+// Start writing every polled snapshot to a log file
+bool record_input(const char *path) {
+    if (rui_input_log.record) fclose(rui_input_log.record);
+    rui_input_log.record = fopen(path, "wb");
+    if (rui_input_log.record == NULL) {
+        TraceLog(LOG_WARNING, "RUI: could not create input log %s", path);
+        return false;
+    }
+    uint32_t header[2] = { RUI_INPUT_LOG_MAGIC, RUI_INPUT_LOG_VERSION };
+    fwrite(header, sizeof(uint32_t), 2, rui_input_log.record);
+    return true;
+}
+
+// Take input from a recorded log instead of the backend. Frames run as fast as
+// possible, or as far apart as when they were recorded if `realtime` is set.
+bool replay_input(const char *path, bool realtime) {
+    if (rui_input_log.replay) fclose(rui_input_log.replay);
+    rui_input_log.replay = fopen(path, "rb");
+    uint32_t header[2] = {0};
+    if (rui_input_log.replay == NULL || fread(header, sizeof(uint32_t), 2, rui_input_log.replay) != 2 ||
+        header[0] != RUI_INPUT_LOG_MAGIC || header[1] < 1 || header[1] > RUI_INPUT_LOG_VERSION) {
+        TraceLog(LOG_WARNING, "RUI: could not read input log %s", path);
+        if (rui_input_log.replay) fclose(rui_input_log.replay);
+        rui_input_log.replay = NULL;
+        return false;
+    }
+    rui_input_log.version = header[1];
+    rui_input_log.realtime = realtime;
+    rui_input_log.finished = false;
+    rui_input_log.frames = 0;
+    rui_input_log.update_total = rui_input_log.update_max = 0;
+    rui_input_log.draw_total = rui_input_log.draw_max = 0;
+    return true;
+}
+
+// Close the input logs; a replay prints its totals
+void stop_input_log(void) {
+    if (rui_input_log.record) fclose(rui_input_log.record);
+    if (rui_input_log.replay) {
+        long frames = rui_input_log.frames > 0 ? rui_input_log.frames : 1;
+        TraceLog(LOG_INFO, "RUI: replayed %ld frames: update %.3f ms avg, %.3f ms max; draw %.3f ms avg, %.3f ms max",
+                 rui_input_log.frames, rui_input_log.update_total * 1000 / frames, rui_input_log.update_max * 1000,
+                 rui_input_log.draw_total * 1000 / frames, rui_input_log.draw_max * 1000);
+        fclose(rui_input_log.replay);
+    }
+    rui_input_log.record = rui_input_log.replay = NULL;
+}
+
+// Keys held down since an earlier frame, for their repeats and releases
+static struct {
+    int keys[RUI_MAX_HELD_KEYS];
+    double next_repeat[RUI_MAX_HELD_KEYS];
+    int count;
+} rui_held_keys = {0};
+
+// Whether pressing `key` also types a character, e.g. KEY_A but not KEY_LEFT
+static bool rui_key_types(int key) {
+    return (key >= KEY_SPACE && key <= KEY_GRAVE) || (key >= KEY_KP_0 && key <= KEY_KP_EQUAL);
+}
+
+// Modifiers are held, not repeated
+static void rui_key_hold(int key, double time) {
+    if (key >= KEY_LEFT_SHIFT && key <= KEY_RIGHT_SUPER) return;
+    for (int i = 0; i < rui_held_keys.count; i++) {
+        if (rui_held_keys.keys[i] == key) return;
+    }
+    if (rui_held_keys.count == RUI_MAX_HELD_KEYS) return;
+    rui_held_keys.keys[rui_held_keys.count] = key;
+    rui_held_keys.next_repeat[rui_held_keys.count++] = time + RUI_KEY_REPEAT_DELAY;
+}
+
+static void rui_key_release(int key) {
+    for (int i = 0; i < rui_held_keys.count; i++) {
+        if (rui_held_keys.keys[i] != key) continue;
+        rui_held_keys.keys[i] = rui_held_keys.keys[--rui_held_keys.count];
+        rui_held_keys.next_repeat[i] = rui_held_keys.next_repeat[rui_held_keys.count];
+        return;
+    }
+}
+
+// Repeats of the held keys that came due by `time`, at the times they came due
+static void rui_key_repeats_until(rui_input *input, double time) {
+    for (int i = 0; i < rui_held_keys.count; i++) {
+        for (double *due = &rui_held_keys.next_repeat[i]; *due <= time; *due += RUI_KEY_REPEAT_INTERVAL) {
+            rui_push_key_event(input, RUI_KEY_REPEAT, rui_held_keys.keys[i], *due);
+        }
+    }
+}
+
+// In on-demand pacing, wake up for the next repeat while a key is held
+static void rui_request_repeat_frame(double now) {
+    if (rui_held_keys.count == 0) return;
+    double next = rui_held_keys.next_repeat[0];
+    for (int i = 1; i < rui_held_keys.count; i++) {
+        if (rui_held_keys.next_repeat[i] < next) next = rui_held_keys.next_repeat[i];
+    }
+    request_frame_in(next - now);
+}
+
+// Turn the backend's keyboard events into the frame's keys, characters and
+// events; the held keys repeat in between them
+static void rui_take_key_events(rui_input *input, const rl_key_event *events, int count) {
+    for (int i = 0; i < count; i++) {
+        const rl_key_event *event = &events[i];
+        rui_key_repeats_until(input, event->time);
+        switch (event->action) {
+        case RL_KEY_PRESS:
+            if (input->key_count < RUI_MAX_INPUT_KEYS) input->keys[input->key_count++] = event->code;
+            rui_push_key_event(input, RUI_KEY_DOWN, event->code, event->time);
+            rui_key_hold(event->code, event->time);
+            break;
+        case RL_KEY_RELEASE:
+            rui_push_key_event(input, RUI_KEY_UP, event->code, event->time);
+            rui_key_release(event->code);
+            break;
+        case RL_KEY_CHAR:
+            if (input->char_count < RUI_MAX_INPUT_CHARS) input->chars[input->char_count++] = event->code;
+            rui_push_key_event(input, RUI_KEY_CHAR, event->code, event->time);
+            break;
+        }
+    }
+    rui_key_repeats_until(input, input->time);
+}
+
+// Turn the frame's keys and characters into ordered events when the backend
+// only has raylib's queues. They hold keys and characters apart, so each
+// character goes right after the key that typed it; characters with no such
+// key, like the ones an input method sends, come last.
+static void rui_poll_key_events(rui_input *input) {
+    double now = input->time;
+    for (int i = 0; i < rui_held_keys.count; i++) {
+        int key = rui_held_keys.keys[i];
+        if (IsKeyDown(key)) continue;
+        rui_push_key_event(input, RUI_KEY_UP, key, now);
+        rui_key_release(key);
+        i--;
+    }
+    rui_key_repeats_until(input, now);
+    int next_char = 0;
+    for (int i = 0; i < input->key_count; i++) {
+        int key = input->keys[i];
+        rui_push_key_event(input, RUI_KEY_DOWN, key, now);
+        if (rui_key_types(key) && next_char < input->char_count) rui_push_key_event(input, RUI_KEY_CHAR, input->chars[next_char++], now);
+        if (!IsKeyDown(key)) rui_push_key_event(input, RUI_KEY_UP, key, now);  // pressed and released within the frame
+        else rui_key_hold(key, now);
+    }
+    while (next_char < input->char_count) rui_push_key_event(input, RUI_KEY_CHAR, input->chars[next_char++], now);
+}
+
+rui_input poll_input(void) {
+    if (rui_input_log.replay) {
+        if (rui_input_log.frames == 0) {
+            // Replays are not throttled by the frame rate or by waiting for input
+            set_frame_pacing(PACING_FIXED);
+            set_target_fps(0);
+        }
+        return rui_input_log_next();
+    }
+    rui_input input = {0};
+    input.time = GetTime();
+    input.dt = GetFrameTime();
+    input.mouse = GetMousePosition();
+    for (int button = 0; button < 3; button++) {
+        input.mouse_down[button] = IsMouseButtonDown(button);
+        input.mouse_pressed[button] = IsMouseButtonPressed(button);
+        input.mouse_released[button] = IsMouseButtonReleased(button);
+    }
+    input.wheel = GetMouseWheelMove();
+    input.shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    rl_key_event events[RUI_MAX_INPUT_EVENTS];
+    int event_count = take_key_events(events, RUI_MAX_INPUT_EVENTS);
+    if (event_count >= 0) {
+        rui_take_key_events(&input, events, event_count);
+        while (GetKeyPressed() > 0 || GetCharPressed() > 0) {}  // the same presses, cut to 16
+    } else {
+        for (int key = GetKeyPressed(); key > 0 && input.key_count < RUI_MAX_INPUT_KEYS; key = GetKeyPressed()) {
+            input.keys[input.key_count++] = key;
+        }
+        for (int c = GetCharPressed(); c > 0 && input.char_count < RUI_MAX_INPUT_CHARS; c = GetCharPressed()) {
+            input.chars[input.char_count++] = c;
+        }
+        rui_poll_key_events(&input);
+    }
+    rui_request_repeat_frame(input.time);
+    if (rui_input_log.record) rui_input_log_write(rui_input_log.record, &input);
+    return input;
+}
+
+//--------------------------- Hit Grid ---------------------------
+// Spatial index of widget bounds for pointer hit testing. The screen is cut
+// into RUI_HIT_CELL-sized cells that each list the widgets overlapping them, so
+// a query tests only the widgets in the pointer's cell. Bounds reaching past the
+// screen are clamped into the border cells. Of the widgets under the pointer,
+// the one with the highest z is on top, and for equal z the one tracked last.
+
+#define RUI_HIT_CELL 64
+
+typedef struct {
+    Rectangle bounds;
+    int z;
+    unsigned order;       // Tracking order, breaks ties in z
+    int next_free;        // Next freed slot while unused
+    bool used;
+} rui_hit_entry;
+
+typedef struct {
+    int *ids;
+    int count;
+    int capacity;
+} rui_hit_cell;
+
+typedef struct {
+    rui_hit_entry *entries;
+    int entry_count;      // Slots handed out, used or freed
+    int entry_capacity;
+    int free_id;          // First freed slot, -1 if none
+    rui_hit_cell *cells;
+    int cols, rows;
+    unsigned next_order;
+    unsigned version;     // Bumped on every change
+    unsigned top_version; // Version and point of the last hit_grid_top, reused while both match
+    Vector2 top_point;
+    int top_id;
+} rui_hit_grid;
+
+// Create a grid covering the screen; call it after init_ui
+rui_hit_grid create_hit_grid(void) {
+    rui_hit_grid grid = {0};
+    grid.cols = GetScreenWidth() / RUI_HIT_CELL + 1;
+    grid.rows = GetScreenHeight() / RUI_HIT_CELL + 1;
+    grid.cells = calloc(grid.cols * grid.rows, sizeof(rui_hit_cell));
+    grid.free_id = -1;
+    grid.version = 1;
+    return grid;
+}
+
+void destroy_hit_grid(rui_hit_grid *grid) {
+    for (int i = 0; i < grid->cols * grid->rows; i++) free(grid->cells[i].ids);
+    free(grid->cells);
+    free(grid->entries);
+    memset(grid, 0, sizeof(*grid));
+}
+
+// Range of cells [x0, x1] x [y0, y1] that a rectangle overlaps
+static void rui_hit_cell_range(const rui_hit_grid *grid, Rectangle bounds, int *x0, int *y0, int *x1, int *y1) {
+    float right = bounds.x + bounds.width, bottom = bounds.y + bounds.height;
+    *x0 = bounds.x < 0 ? 0 : (int)(bounds.x / RUI_HIT_CELL);
+    *y0 = bounds.y < 0 ? 0 : (int)(bounds.y / RUI_HIT_CELL);
+    *x1 = right < 0 ? 0 : (int)(right / RUI_HIT_CELL);
+    *y1 = bottom < 0 ? 0 : (int)(bottom / RUI_HIT_CELL);
+    if (*x0 >= grid->cols) *x0 = grid->cols - 1;
+    if (*x1 >= grid->cols) *x1 = grid->cols - 1;
+    if (*y0 >= grid->rows) *y0 = grid->rows - 1;
+    if (*y1 >= grid->rows) *y1 = grid->rows - 1;
+}
+
+// Add (`link`) or remove an entry from the cells its bounds overlap
+static void rui_hit_link(rui_hit_grid *grid, int id, bool link) {
+    int x0, y0, x1, y1;
+    rui_hit_cell_range(grid, grid->entries[id].bounds, &x0, &y0, &x1, &y1);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            rui_hit_cell *cell = &grid->cells[y * grid->cols + x];
+            if (link) {
+                if (cell->count == cell->capacity) {
+                    cell->capacity = cell->capacity ? cell->capacity * 2 : 8;
+                    cell->ids = realloc(cell->ids, cell->capacity * sizeof(int));
+                }
+                cell->ids[cell->count++] = id;
+            } else {
+                for (int i = 0; i < cell->count; i++) {
+                    if (cell->ids[i] == id) {
+                        cell->ids[i] = cell->ids[--cell->count];
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Track a rectangle; returns its id
+int hit_grid_add(rui_hit_grid *grid, Rectangle bounds, int z) {
+    int id = grid->free_id;
+    if (id >= 0) {
+        grid->free_id = grid->entries[id].next_free;
+    } else {
+        if (grid->entry_count == grid->entry_capacity) {
+            grid->entry_capacity = grid->entry_capacity ? grid->entry_capacity * 2 : 64;
+            grid->entries = realloc(grid->entries, grid->entry_capacity * sizeof(rui_hit_entry));
+        }
+        id = grid->entry_count++;
+    }
+    grid->entries[id] = (rui_hit_entry){ bounds, z, grid->next_order++, -1, true };
+    rui_hit_link(grid, id, true);
+    grid->version++;
+    return id;
+}
+
+// Update the bounds of a tracked rectangle, e.g. after its window moved
+void hit_grid_move(rui_hit_grid *grid, int id, Rectangle bounds) {
+    rui_hit_entry *entry = &grid->entries[id];
+    if (entry->bounds.x == bounds.x && entry->bounds.y == bounds.y &&
+        entry->bounds.width == bounds.width && entry->bounds.height == bounds.height) return;
+    int ox0, oy0, ox1, oy1, x0, y0, x1, y1;
+    rui_hit_cell_range(grid, entry->bounds, &ox0, &oy0, &ox1, &oy1);
+    rui_hit_cell_range(grid, bounds, &x0, &y0, &x1, &y1);
+    bool same_cells = ox0 == x0 && oy0 == y0 && ox1 == x1 && oy1 == y1;  // Small moves usually stay in the same cells
+    if (!same_cells) rui_hit_link(grid, id, false);
+    entry->bounds = bounds;
+    if (!same_cells) rui_hit_link(grid, id, true);
+    grid->version++;
+}
+
+void hit_grid_remove(rui_hit_grid *grid, int id) {
+    rui_hit_link(grid, id, false);
+    grid->entries[id].used = false;
+    grid->entries[id].next_free = grid->free_id;
+    grid->free_id = id;
+    grid->version++;
+}
+
+static bool rui_hit_above(const rui_hit_grid *grid, int a, int b) {
+    const rui_hit_entry *ea = &grid->entries[a], *eb = &grid->entries[b];
+    return ea->z != eb->z ? ea->z > eb->z : ea->order > eb->order;
+}
+
+static const rui_hit_cell *rui_hit_cell_at(const rui_hit_grid *grid, Vector2 point) {
+    int x, y, x1, y1;
+    rui_hit_cell_range(grid, (Rectangle){ point.x, point.y, 0, 0 }, &x, &y, &x1, &y1);
+    return &grid->cells[y * grid->cols + x];
+}
+
+// Ids of the tracked rectangles containing `point`, top-most first; returns how many, at most `max`
+int hit_grid_query(const rui_hit_grid *grid, Vector2 point, int *ids, int max) {
+    const rui_hit_cell *cell = rui_hit_cell_at(grid, point);
+    int count = 0;
+    for (int i = 0; i < cell->count; i++) {
+        int id = cell->ids[i];
+        if (!CheckCollisionPointRec(point, grid->entries[id].bounds)) continue;
+        // Insertion into the sorted result, dropping whatever falls past `max`
+        int at = count < max ? count++ : max;
+        while (at > 0 && rui_hit_above(grid, id, ids[at - 1])) {
+            if (at < max) ids[at] = ids[at - 1];
+            at--;
+        }
+        if (at < max) ids[at] = id;
+    }
+    return count;
+}
+
+// Id of the top-most tracked rectangle containing `point`, or -1
+int hit_grid_top(rui_hit_grid *grid, Vector2 point) {
+    if (grid->top_version == grid->version && grid->top_point.x == point.x && grid->top_point.y == point.y) return grid->top_id;
+    int top = -1;
+    hit_grid_query(grid, point, &top, 1);
+    grid->top_version = grid->version;
+    grid->top_point = point;
+    grid->top_id = top;
+    return top;
+}
+
+// A widget's entry in a hit grid
+typedef struct {
+    rui_hit_grid *grid;   // NULL when the widget is not tracked
+    int id;
+} rui_hit;
+
+// Whether the pointer hits a widget: it must be the top-most tracked widget there, or be inside `bounds` if untracked
+static bool rui_hit_test(const rui_hit *hit, Vector2 point, Rectangle bounds) {
+    if (hit->grid == NULL) return CheckCollisionPointRec(point, bounds);
+    return hit_grid_top(hit->grid, point) == hit->id;
+}
+
+static void rui_hit_move(const rui_hit *hit, Rectangle bounds) {
+    if (hit->grid) hit_grid_move(hit->grid, hit->id, bounds);
+}
+
+static rui_hit rui_hit_track(rui_hit_grid *grid, Rectangle bounds, int z) {
+    return (rui_hit){ grid, hit_grid_add(grid, bounds, z) };
+}
+
+// Take a widget out of its grid, so its id is freed and no longer hides what is below it
+static void rui_hit_untrack(rui_hit *hit) {
+    if (hit->grid) hit_grid_remove(hit->grid, hit->id);
+    *hit = (rui_hit){ NULL, 0 };
+}
+
+//--------------------------- Batch Hit Testing ---------------------------
+// Point-in-rectangle over many rectangles kept as separate x, y, width and
+// height arrays, testing 4 (SSE2), 8 (AVX) or 16 (AVX-512) rectangles per
+// instruction. The widest set the CPU has is picked on the first call; other
+// architectures, or builds with RUI_NO_SIMD, use the scalar loop. Later
+// rectangles are drawn on top, so the scan runs from the end and stops at the
+// first hit. The test is the same as CheckCollisionPointRec.
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(RUI_NO_SIMD)
+#define RUI_SIMD_X86
+#include <immintrin.h>
+#endif
+
+typedef int (*rui_hit_rects_fn)(const float *x, const float *y, const float *width, const float *height, int count, Vector2 point);
+
+static int rui_hit_rects_scalar(const float *x, const float *y, const float *width, const float *height, int count, Vector2 point) {
+    for (int i = count - 1; i >= 0; i--) {
+        if (point.x >= x[i] && point.x < x[i] + width[i] && point.y >= y[i] && point.y < y[i] + height[i]) return i;
+    }
+    return -1;
+}
+
+#ifdef RUI_SIMD_X86
+__attribute__((target("sse2")))
+static int rui_hit_rects_sse2(const float *x, const float *y, const float *width, const float *height, int count, Vector2 point) {
+    __m128 px = _mm_set1_ps(point.x), py = _mm_set1_ps(point.y);
+    int i = count;
+    while (i >= 4) {
+        i -= 4;
+        __m128 left = _mm_loadu_ps(x + i), top = _mm_loadu_ps(y + i);
+        __m128 in_x = _mm_and_ps(_mm_cmpge_ps(px, left), _mm_cmplt_ps(px, _mm_add_ps(left, _mm_loadu_ps(width + i))));
+        __m128 in_y = _mm_and_ps(_mm_cmpge_ps(py, top), _mm_cmplt_ps(py, _mm_add_ps(top, _mm_loadu_ps(height + i))));
+        int mask = _mm_movemask_ps(_mm_and_ps(in_x, in_y));
+        if (mask) return i + 31 - __builtin_clz(mask);
+    }
+    return rui_hit_rects_scalar(x, y, width, height, i, point);
+}
+
+__attribute__((target("avx")))
+static int rui_hit_rects_avx(const float *x, const float *y, const float *width, const float *height, int count, Vector2 point) {
+    __m256 px = _mm256_set1_ps(point.x), py = _mm256_set1_ps(point.y);
+    int i = count;
+    while (i >= 8) {
+        i -= 8;
+        __m256 left = _mm256_loadu_ps(x + i), top = _mm256_loadu_ps(y + i);
+        __m256 in_x = _mm256_and_ps(_mm256_cmp_ps(px, left, _CMP_GE_OQ), _mm256_cmp_ps(px, _mm256_add_ps(left, _mm256_loadu_ps(width + i)), _CMP_LT_OQ));
+        __m256 in_y = _mm256_and_ps(_mm256_cmp_ps(py, top, _CMP_GE_OQ), _mm256_cmp_ps(py, _mm256_add_ps(top, _mm256_loadu_ps(height + i)), _CMP_LT_OQ));
+        int mask = _mm256_movemask_ps(_mm256_and_ps(in_x, in_y));
+        if (mask) return i + 31 - __builtin_clz(mask);
+    }
+    return rui_hit_rects_sse2(x, y, width, height, i, point);
+}
+
+__attribute__((target("avx512f")))
+static int rui_hit_rects_avx512(const float *x, const float *y, const float *width, const float *height, int count, Vector2 point) {
+    __m512 px = _mm512_set1_ps(point.x), py = _mm512_set1_ps(point.y);
+    int i = count;
+    while (i >= 16) {
+        i -= 16;
+        __m512 left = _mm512_loadu_ps(x + i), top = _mm512_loadu_ps(y + i);
+        __mmask16 mask = _mm512_cmp_ps_mask(px, left, _CMP_GE_OQ);
+        mask = _mm512_mask_cmp_ps_mask(mask, px, _mm512_add_ps(left, _mm512_loadu_ps(width + i)), _CMP_LT_OQ);
+        mask = _mm512_mask_cmp_ps_mask(mask, py, top, _CMP_GE_OQ);
+        mask = _mm512_mask_cmp_ps_mask(mask, py, _mm512_add_ps(top, _mm512_loadu_ps(height + i)), _CMP_LT_OQ);
+        if (mask) return i + 31 - __builtin_clz(mask);
+    }
+    return rui_hit_rects_avx(x, y, width, height, i, point);
+}
+#endif
+
+static rui_hit_rects_fn rui_hit_rects = NULL;
+
+// Index of the last (top-most) of `count` rectangles containing `point`, or -1
+int hit_test_rects(const float *x, const float *y, const float *width, const float *height, int count, Vector2 point) {
+    if (rui_hit_rects == NULL) {
+        rui_hit_rects = rui_hit_rects_scalar;
+#ifdef RUI_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) rui_hit_rects = rui_hit_rects_avx512;
+        else if (__builtin_cpu_supports("avx")) rui_hit_rects = rui_hit_rects_avx;
+        else if (__builtin_cpu_supports("sse2")) rui_hit_rects = rui_hit_rects_sse2;
+#endif
+    }
+    return rui_hit_rects(x, y, width, height, count, point);
+}
+
+// Rectangles of a widget collection (radio buttons, a list of buttons,
+// dropdown options), stored one coordinate per array for hit_test_rects
+typedef struct {
+    float *x;
+    float *y;
+    float *width;
+    float *height;
+    int count;
+    int capacity;
+} rui_rect_array;
+
+// Append a rectangle; returns its index
+int rect_array_add(rui_rect_array *rects, Rectangle bounds) {
+    if (rects->count == rects->capacity) {
+        rects->capacity = rects->capacity ? rects->capacity * 2 : 64;
+        rects->x = realloc(rects->x, rects->capacity * sizeof(float));
+        rects->y = realloc(rects->y, rects->capacity * sizeof(float));
+        rects->width = realloc(rects->width, rects->capacity * sizeof(float));
+        rects->height = realloc(rects->height, rects->capacity * sizeof(float));
+    }
+    int i = rects->count++;
+    rects->x[i] = bounds.x;
+    rects->y[i] = bounds.y;
+    rects->width[i] = bounds.width;
+    rects->height[i] = bounds.height;
+    return i;
+}
+
+void rect_array_set(rui_rect_array *rects, int i, Rectangle bounds) {
+    rects->x[i] = bounds.x;
+    rects->y[i] = bounds.y;
+    rects->width[i] = bounds.width;
+    rects->height[i] = bounds.height;
+}
+
+Rectangle rect_array_get(const rui_rect_array *rects, int i) {
+    return (Rectangle){ rects->x[i], rects->y[i], rects->width[i], rects->height[i] };
+}
+
+// Index of the top-most rectangle containing `point`, or -1
+int rect_array_hit(const rui_rect_array *rects, Vector2 point) {
+    return hit_test_rects(rects->x, rects->y, rects->width, rects->height, rects->count, point);
+}
+
+void free_rect_array(rui_rect_array *rects) {
+    free(rects->x);
+    free(rects->y);
+    free(rects->width);
+    free(rects->height);
+    memset(rects, 0, sizeof(*rects));
+}
+
+//--------------------------- Virtual List ---------------------------
+// Rows of a scrolling MenuWindow that only exist while they are visible. The
+// list knows how many rows there are and how tall each one is; drawing a row
+// is left to a callback, which is only called for the rows that intersect the
+// window's clip area. Variable heights are kept as a prefix sum of row tops,
+// so finding the row at a scroll offset is a binary search, and a million
+// rows cost one pass when the heights are set and nothing per frame.
+
+typedef float (*rui_row_height_fn)(void *user, int row);
+typedef void (*rui_row_render_fn)(void *user, int row, Rectangle bounds);
+
+typedef struct {
+    int count;
+    float row_height;               // Height of every row when height_of is NULL
+    rui_row_height_fn height_of;
+    rui_row_render_fn render_row;
+    void *user;                     // Passed to the callbacks
+    double *tops;                   // Variable heights: tops[i] is the top of row i, tops[count] the list height
+    int capacity;
+} rui_virtual_list;
+
+rui_virtual_list create_virtual_list(int count, float row_height, rui_row_render_fn render_row, void *user) {
+    rui_virtual_list list = {0};
+    list.count = count;
+    list.row_height = row_height;
+    list.render_row = render_row;
+    list.user = user;
+    return list;
+}
+
+void destroy_virtual_list(rui_virtual_list *list) {
+    free(list->tops);
+    list->tops = NULL;
+    list->capacity = 0;
+}
+
+// Recompute the row tops from row `first` on, after the heights of those rows changed
+void invalidate_virtual_list_rows(rui_virtual_list *list, int first) {
+    if (!list->height_of) return;
+    if (list->capacity < list->count + 1) {
+        list->capacity = list->count + 1 > list->capacity * 2 ? list->count + 1 : list->capacity * 2;
+        list->tops = realloc(list->tops, list->capacity * sizeof(double));
+        first = 0;
+    }
+    if (first < 0) first = 0;
+    if (first == 0) list->tops[0] = 0;
+    for (int i = first; i < list->count; i++) list->tops[i + 1] = list->tops[i] + list->height_of(list->user, i);
+}
+
+// Give each row the height returned by `height_of`, or NULL to go back to row_height
+void set_virtual_list_heights(rui_virtual_list *list, rui_row_height_fn height_of) {
+    list->height_of = height_of;
+    invalidate_virtual_list_rows(list, 0);
+}
+
+// Rows appended at the end only cost their own heights
+void set_virtual_list_count(rui_virtual_list *list, int count) {
+    int first = count < list->count ? count : list->count;
+    list->count = count;
+    invalidate_virtual_list_rows(list, first);
+}
+
+double virtual_list_height(const rui_virtual_list *list) {
+    return list->height_of ? list->tops[list->count] : (double)list->count * list->row_height;
+}
+
+double virtual_list_row_top(const rui_virtual_list *list, int row) {
+    return list->height_of ? list->tops[row] : (double)row * list->row_height;
+}
+
+// Row covering offset `y` from the top of the list, clamped to the rows there are
+int virtual_list_row_at(const rui_virtual_list *list, double y) {
+    if (list->count == 0) return 0;
+    int row;
+    if (!list->height_of) {
+        row = list->row_height > 0 ? (int)(y / list->row_height) : 0;
+    } else {
+        // Last row whose top is at or above y
+        int low = 0, high = list->count;
+        while (high - low > 1) {
+            int mid = (low + high) / 2;
+            if (list->tops[mid] <= y) low = mid;
+            else high = mid;
+        }
+        row = low;
+    }
+    if (row < 0) row = 0;
+    if (row >= list->count) row = list->count - 1;
+    return row;
+}
+
+// Draw the rows visible in `clip`, the list being scrolled by `offset`
+static void rui_virtual_list_render(const rui_virtual_list *list, Rectangle clip, double offset) {
+    if (!list->render_row || list->count == 0) return;
+    for (int row = virtual_list_row_at(list, offset); row < list->count; row++) {
+        double top = virtual_list_row_top(list, row) - offset;
+        if (top >= clip.height) break;
+        double bottom = list->height_of ? list->tops[row + 1] - offset : top + list->row_height;
+        Rectangle bounds = { clip.x, clip.y + (float)top, clip.width, (float)(bottom - top) };
+        if (is_damaged(bounds)) list->render_row(list->user, row, bounds);
+    }
+}
+
 //--------------------------- window ---------------------------------
 
 // Enum to define different modes for the menu window
@@ -46,6 +889,24 @@ typedef enum {
     WINDOW_MODE_RESIZABLE   // Window can be moved and resized
 } WindowMode;
 
+// How a container places its children, see add_child_layout
+typedef enum {
+    RUI_LAYOUT_NONE,    // Children keep their own position
+    RUI_LAYOUT_STACK,   // One after the other at their natural size
+    RUI_LAYOUT_FLEX,    // As a stack, with the free space shared by the children that grow
+    RUI_LAYOUT_GRID     // Rows of equal-width cells
+} rui_layout_kind;
+
+typedef struct {
+    rui_layout_kind kind;
+    bool horizontal;    // Stack and flex: along x instead of y
+    float padding;      // Around the children
+    float spacing;      // Between children
+    int columns;        // Grid
+} rui_layout;
+
+typedef struct rui_layout_node rui_layout_node;
+
 // Struct to represent a menu window with all its properties
 typedef struct {
 	int x, y;
@@ -63,6 +924,15 @@ typedef struct {
     Rectangle scrollBar;     // Bounding box for the scroll bar
     bool isScrollBarDragging;// Indicates if the scroll bar is being dragged
     float scrollBarDragOffset;// Offset between mouse and scroll bar position during dragging
+    Rectangle oldBounds;     // Bounds before the last update_menu_window, to tell moves from layout changes
+    int surface;             // Cached surface holding the window and its children, -1 when not cached
+    rui_layout_node *children; // Layout tree of the widgets added with add_child_*, node 0 is the window
+    int child_count;
+    int child_capacity;
+    bool layout_dirty;       // A child was added or its size hint changed
+    Vector2 laid_out_size;   // Window size the children were laid out for
+    rui_virtual_list *list;  // Rows drawn in the content area, see set_menu_window_list
+    void *focus_pressed;     // Child of a focus chain the pointer was pressed on in the last update, see update_focus
 } MenuWindow;
 
 // Function to create and initialize a menu window
@@ -92,21 +962,46 @@ MenuWindow create_menu_window(
     };
     window.isScrollBarDragging = false;
     window.scrollBarDragOffset = 0;
+    window.oldBounds = window.bounds;
+    window.surface = -1;
     return window;
 }
 
+// Function to keep the window and its children in an offscreen surface, so dragging
+// the window recomposites one quad instead of redrawing every widget
+void set_menu_window_cached(MenuWindow *window, bool cached) {
+    if (cached && window->surface < 0) {
+        window->surface = load_surface();
+        if (window->surface >= 0) move_surface(window->surface, window->bounds);
+    } else if (!cached && window->surface >= 0) {
+        unload_surface(window->surface);
+        window->surface = -1;
+        damage_rect(window->bounds);
+    }
+}
+
+// Area the list rows are drawn in
+static Rectangle rui_menu_window_clip(const MenuWindow *window) {
+    return (Rectangle){ window->bounds.x + 5, window->bounds.y + 35, window->bounds.width - 20, window->bounds.height - 40 };
+}
+
 // Function to update the window's behavior based on user interaction
-void update_menu_window(MenuWindow *window) {
-    Vector2 mousePos = GetMousePosition(); // Get current mouse position
+void update_menu_window(MenuWindow *window, const rui_input *input) {
+    Vector2 mousePos = input->mouse; // Get current mouse position
+    Rectangle oldBounds = window->bounds;
+    window->oldBounds = oldBounds;
+    if (window->list) window->contentHeight = virtual_list_height(window->list) + 10;
+    Rectangle oldScrollBar = window->scrollBar;
+    float oldScrollOffset = window->scrollOffset;
 
     // Handle window dragging if movable and title bar is visible
     if (window->movable && window->showTitle) {
         Rectangle titleBar = { window->bounds.x, window->bounds.y, window->bounds.width, 30 };
-        if (CheckCollisionPointRec(mousePos, titleBar) && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        if (CheckCollisionPointRec(mousePos, titleBar) && input->mouse_pressed[MOUSE_BUTTON_LEFT]) {
             window->isDragging = true;
             window->dragOffset = (Vector2){ mousePos.x - window->bounds.x, mousePos.y - window->bounds.y };
         }
-        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) window->isDragging = false;
+        if (!input->mouse_down[MOUSE_BUTTON_LEFT]) window->isDragging = false;
 
         if (window->isDragging) {
             // Update window position
@@ -123,10 +1018,10 @@ void update_menu_window(MenuWindow *window) {
     // Handle window resizing if resizable
     if (window->mode == WINDOW_MODE_RESIZABLE) {
         Rectangle resizeArea = { window->bounds.x + window->bounds.width - 10, window->bounds.y + window->bounds.height - 10, 10, 10 };
-        if (CheckCollisionPointRec(mousePos, resizeArea) && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        if (CheckCollisionPointRec(mousePos, resizeArea) && input->mouse_pressed[MOUSE_BUTTON_LEFT]) {
             window->isResizing = true;
         }
-        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) window->isResizing = false;
+        if (!input->mouse_down[MOUSE_BUTTON_LEFT]) window->isResizing = false;
 
         if (window->isResizing) {
             // Update window size
@@ -144,16 +1039,16 @@ void update_menu_window(MenuWindow *window) {
         float maxOffset = window->contentHeight - (window->bounds.height - 30);
 
         // Scroll with mouse wheel
-        window->scrollOffset -= GetMouseWheelMove() * 20;
+        window->scrollOffset -= input->wheel * 20;
         if (window->scrollOffset < 0) window->scrollOffset = 0;
         if (window->scrollOffset > maxOffset) window->scrollOffset = maxOffset;
 
         // Dragging the scroll bar
-        if (CheckCollisionPointRec(mousePos, window->scrollBar) && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        if (CheckCollisionPointRec(mousePos, window->scrollBar) && input->mouse_pressed[MOUSE_BUTTON_LEFT]) {
             window->isScrollBarDragging = true;
             window->scrollBarDragOffset = mousePos.y - window->scrollBar.y;
         }
-        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) window->isScrollBarDragging = false;
+        if (!input->mouse_down[MOUSE_BUTTON_LEFT]) window->isScrollBarDragging = false;
 
         if (window->isScrollBarDragging) {
             // Update scroll bar position
@@ -167,63 +1062,128 @@ void update_menu_window(MenuWindow *window) {
                                     (window->bounds.height - 30 - window->scrollBar.height)) * maxOffset;
         }
 
+        // Whole pixels, so a cached list scrolls by shifting its surface instead of being redrawn
+        window->scrollOffset = (float)(int)(window->scrollOffset + 0.5f);
+        if (window->scrollOffset > (int)maxOffset) window->scrollOffset = (int)maxOffset;
+
         // Adjust scroll bar height and position dynamically
         float visibleRatio = (window->bounds.height - 30) / window->contentHeight;
         window->scrollBar.height = (window->bounds.height - 30) * visibleRatio;
+        if (window->scrollBar.height < 10) window->scrollBar.height = 10;  // Still grabbable over long lists
         window->scrollBar.x = window->bounds.x + window->bounds.width - 15;
         window->scrollBar.y = window->bounds.y + 30 +
             (window->scrollOffset / maxOffset) * (window->bounds.height - 30 - window->scrollBar.height);
     }
+
+    // Drags should track the pointer at full refresh rate
+    if (window->isDragging || window->isResizing || window->isScrollBarDragging) request_high_refresh();
+
+    // Redraw only when the window moved, resized or scrolled
+    bool scrolled = window->scrollOffset != oldScrollOffset;
+    bool resized = window->bounds.width != oldBounds.width || window->bounds.height != oldBounds.height;
+    // A cached window is only recomposited when it moves; resizing it invalidates its surface
+    if (window->surface >= 0) move_surface(window->surface, window->bounds);
+    if (scrolled && !resized && window->surface >= 0 && window->child_count == 0) {
+        // Only the list scrolls: shift the rows already in the surface and draw
+        // the ones scrolled into view, plus the scroll bar track
+        scroll_surface(window->surface, rui_menu_window_clip(window), 0, oldScrollOffset - window->scrollOffset);
+        damage_rect((Rectangle){ window->bounds.x + window->bounds.width - 15, window->bounds.y + 30,
+                                 15, window->bounds.height - 30 });
+    } else if (scrolled ||
+        window->scrollBar.x - window->bounds.x != oldScrollBar.x - oldBounds.x ||
+        window->scrollBar.y - window->bounds.y != oldScrollBar.y - oldBounds.y ||
+        window->scrollBar.height != oldScrollBar.height) {
+        damage_rect(window->bounds);
+    }
+    if (window->surface < 0) rui_damage_move(oldBounds, window->bounds);
+}
+
+// Damage for a child laid out relative to `menu`. Moving along with a cached
+// window changes nothing in the window's surface, so nothing is damaged.
+static void rui_damage_child_move(MenuWindow *menu, Rectangle old_area, Rectangle new_area) {
+    if (menu->surface >= 0 &&
+        old_area.x - menu->oldBounds.x == new_area.x - menu->bounds.x &&
+        old_area.y - menu->oldBounds.y == new_area.y - menu->bounds.y &&
+        old_area.width == new_area.width && old_area.height == new_area.height) return;
+    rui_damage_move(old_area, new_area);
 }
 
 // Function to render the menu window and its components
 void render_menu_window(MenuWindow *window) {
+    if (!is_damaged(window->bounds)) return;
+
     // Draw window background
-    DrawRectangleRec(window->bounds, LIGHTGRAY);
+    draw_rectangle_from_rect(window->bounds, COLOR_LIGHTGRAY);
 
     // Draw title bar if enabled
     if (window->showTitle) {
         Rectangle titleBar = { window->bounds.x, window->bounds.y, window->bounds.width, 30 };
-        DrawRectangleRec(titleBar, DARKGRAY);
-        DrawText(window->title, window->bounds.x + 5, window->bounds.y + 5, 20, RAYWHITE);
+        draw_rectangle_from_rect(titleBar, COLOR_DARKGRAY);
+        draw_text(window->title, window->bounds.x + 5, window->bounds.y + 5, 20, COLOR_RAYWHITE);
     }
 
     // Draw resize handle if resizable
     if (window->mode == WINDOW_MODE_RESIZABLE) {
-        DrawRectangle(window->bounds.x + window->bounds.width - 10, window->bounds.y + window->bounds.height - 10, 10, 10, DARKGRAY);
+        draw_rectangle(window->bounds.x + window->bounds.width - 10, window->bounds.y + window->bounds.height - 10, 10, 10, COLOR_DARKGRAY);
     }
 
     // Draw scroll bar if scrolling is enabled
     if (window->scrollEnabled && window->contentHeight > window->bounds.height - 30) {
-        DrawRectangleRec(window->scrollBar, GRAY);
+        draw_rectangle_from_rect(window->scrollBar, COLOR_GRAY);
 
         // Draw the scroll thumb's visible area
         float thumbY = window->scrollBar.y;
         float thumbHeight = window->scrollBar.height;
-        DrawRectangle(window->scrollBar.x + 2, thumbY + 2, window->scrollBar.width - 4, thumbHeight - 4, DARKGRAY);
+        draw_rectangle(window->scrollBar.x + 2, thumbY + 2, window->scrollBar.width - 4, thumbHeight - 4, COLOR_DARKGRAY);
     }
 
     // Define clipping area for scrollable content
-    Rectangle clipArea = { window->bounds.x + 5, window->bounds.y + 35, window->bounds.width - 20, window->bounds.height - 40 };
-    BeginScissorMode(clipArea.x, clipArea.y, clipArea.width, clipArea.height);
+    Rectangle clipArea = rui_menu_window_clip(window);
+    begin_scissor(clipArea.x, clipArea.y, clipArea.width, clipArea.height);
+
+    // Only the rows inside the clip area are drawn
+    if (window->list) rui_virtual_list_render(window->list, clipArea, window->scrollOffset);
+
+    end_scissor();
+}
+
+// Show a virtual list in the window's content area. The window's content
+// height follows the list from then on. The list belongs to the application.
+void set_menu_window_list(MenuWindow *window, rui_virtual_list *list) {
+    window->list = list;
+    if (list) window->contentHeight = virtual_list_height(list) + 10;  // With the margins around the clip area
+    damage_rect(window->bounds);
+}
 
-    // Render content with scrolling offset
-    // float yOffset = 30 - window->scrollOffset;
-    // for (int i = 0; i < 10; i++) {
-    //     float rectY = window->bounds.y + yOffset + i * 50;
-    //     if (rectY + 40 >= clipArea.y && rectY <= clipArea.y + clipArea.height) {
-    //         DrawRectangle(window->bounds.x + 10, rectY, window->bounds.width - 30, 40, i % 2 == 0 ? BLUE : GREEN);
-    //         DrawText(TextFormat("Item %d", i + 1), window->bounds.x + 15, rectY + 10, 20, RAYWHITE);
-    //     }
-    // }
+// Row of the window's list under a screen point, or -1
+int get_menu_window_list_row(const MenuWindow *window, Vector2 point) {
+    Rectangle clip = rui_menu_window_clip(window);
+    if (!window->list || window->list->count == 0 || !CheckCollisionPointRec(point, clip)) return -1;
+    double y = point.y - clip.y + window->scrollOffset;
+    if (y >= virtual_list_height(window->list)) return -1;
+    return virtual_list_row_at(window->list, y);
+}
+
+// Function to start rendering a window and its children. Returns false when the
+// window is cached and up to date, in which case its children need not be rendered.
+// Call end_menu_window after the children either way.
+bool begin_menu_window(MenuWindow *window) {
+    if (window->surface >= 0) {
+        if (!begin_surface(window->surface)) return false;
+    }
+    render_menu_window(window);
+    return true;
+}
 
-    EndScissorMode();
+// Function to finish a window started with begin_menu_window
+void end_menu_window(MenuWindow *window) {
+    if (window->surface >= 0) end_surface(window->surface);
 }
 
 
 void draw_rect(MenuWindow * menu){
  	
- 	DrawRectangle(menu->bounds.x+(10), menu->bounds.y+(10), 300, 700, RED);
+ 	draw_rectangle(menu->bounds.x+(10), menu->bounds.y+(10), 300, 700, COLOR_RED);
  }
 
 
@@ -243,6 +1203,7 @@ typedef struct {
     RUI_COLOR clicked_color;
     bool is_hovered;
     bool is_clicked;
+    rui_hit hit;          // Entry in a hit grid, see track_button
 
 } Button;
 
@@ -264,115 +1225,619 @@ Button create_button(char *text, float x, float y) {
     return new_button;
 }
 
+// Rounded body and centered label of a button, shared by Button and context buttons
+static void rui_draw_button(Rectangle bounds, const char *text, int font_size, RUI_COLOR color, RUI_COLOR text_color) {
+    float roundness = 0.2f;
+    int segments = 10;
+    draw_rectangle_rounded(bounds, roundness, segments, color);
+    // Measure text width to center it horizontally
+    int text_width = measure_text(text, font_size);
+    int text_x = bounds.x + (bounds.width - text_width) / 2;
+    int text_y = bounds.y + (bounds.height - font_size) / 2;
+    draw_text(text, text_x, text_y, font_size, text_color);
+}
+
 void render_button(Button *button) {
+    if (!is_damaged(toRaylibRectangle(button->button_bounds))) return;
+
     RUI_COLOR draw_color = button->button_color;  // Updated to match `button_color`
 
     if (button->is_hovered) draw_color = button->hover_color;
     if (button->is_clicked) draw_color = button->clicked_color;
 
-    float roundness = 0.2f;
-    int segments = 10;
-
-
     // Convert rui_rect to Raylib Rectangle
-    Rectangle raylibRect = toRaylibRectangle(button->button_bounds);
-
-    // Use the Raylib Rectangle for drawing
-    draw_rectangle_rounded(raylibRect, roundness, segments, draw_color);
-    // Measure text width to center it horizontally
-        int text_width = MeasureText(button->text, button->font_size);
-        int text_x = button->button_bounds.x + (button->button_bounds.width - text_width) / 2;
-        int text_y = button->button_bounds.y + (button->button_bounds.height - button->font_size) / 2;
-    
-        draw_text(button->text, text_x, text_y, button->font_size, button->text_color);
+    rui_draw_button(toRaylibRectangle(button->button_bounds), button->text, button->font_size, draw_color, button->text_color);
 }
 
-bool update_button(Button *button) {
-    Vector2 mousePoint = GetMousePosition();
+bool update_button(Button *button, const rui_input *input) {
+    Vector2 mousePoint = input->mouse;
 
     // Convert rui_rect to Raylib Rectangle
     Rectangle raylibRect = toRaylibRectangle(button->button_bounds);
 
-    button->is_hovered = CheckCollisionPointRec(mousePoint, raylibRect);
+    bool was_hovered = button->is_hovered;
+    bool was_clicked = button->is_clicked;
+    bool clicked = false;
+    button->is_hovered = rui_hit_test(&button->hit, mousePoint, raylibRect);
     button->is_clicked = false;
 
     if (button->is_hovered) {
-        if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+        if (input->mouse_down[MOUSE_LEFT_BUTTON]) {
             button->is_clicked = true;
         }
-        else if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-            return true; // Button was clicked
+        else if (input->mouse_released[MOUSE_LEFT_BUTTON]) {
+            clicked = true; // Button was clicked
         }
     }
-    return false; // Button was not clicked
+    if (button->is_hovered != was_hovered || button->is_clicked != was_clicked) {
+        damage_rect(raylibRect);
+    }
+    return clicked;
 }
 
 void update_button_position(Button *button, MenuWindow *menu) {
+    Rectangle old_bounds = toRaylibRectangle(button->button_bounds);
     // Adjust button position relative to the menu
     button->button_bounds.x = menu->bounds.x + button->x;
     button->button_bounds.y = menu->bounds.y + button->y;
+    rui_damage_child_move(menu, old_bounds, toRaylibRectangle(button->button_bounds));
+    rui_hit_move(&button->hit, toRaylibRectangle(button->button_bounds));
 }
 
-//--------------------------- Text Box Struct ---------------------------
+// Hit test the button through a grid, so it only reacts when it is the top-most tracked widget under the pointer
+void track_button(rui_hit_grid *grid, Button *button, int z) {
+    button->hit = rui_hit_track(grid, toRaylibRectangle(button->button_bounds), z);
+}
+
+// Remove a button from its hit grid, e.g. before destroying it
+void untrack_button(Button *button) {
+    rui_hit_untrack(&button->hit);
+}
+
+//--------------------------- Text Buffer ---------------------------
+// Growable text with a gap at the edit position, so typing or deleting at the
+// cursor moves no other bytes. Edits happen at the gap; callers move it to
+// their cursor first, which is free when it is already there. The starts of lines 1.. (the byte after each
+// '\n') are kept the same way: starts at or before the cursor are stored from
+// the beginning of the text, starts after it as their distance from the end,
+// so an edit at the cursor leaves both halves valid. Moving the cursor moves
+// only the bytes and line starts it passes over.
 
 typedef struct {
-    rui_rect textbox_bounds;
-    char textbox_text[MAX_LINES][MAX_LINE_LENGTH];
-    int line_count;
-    RUI_COLOR background_color;
-    bool active;
-    int current_line;
-    int current_pos;
-    const char *placeholder;
-    RUI_COLOR placeholder_color;
-    int font_size;
-    RUI_COLOR text_color;
-    float x,y;
-} TextBox;
+    char *data;           // data[0..gap_start) is before the cursor, data[gap_end..capacity) after it
+    int capacity;
+    int gap_start;        // edit position
+    int gap_end;
+    int *lines;           // lines[0..line_gap_start) from the start, lines[line_gap_end..line_capacity) from the end
+    int line_capacity;
+    int line_gap_start;   // also the line of the edit position
+    int line_gap_end;
+} rui_text_buffer;
+
+int rui_text_length(const rui_text_buffer *buffer) {
+    return buffer->capacity - (buffer->gap_end - buffer->gap_start);
+}
 
-// Initialize a multiline text box with placeholder text
-TextBox create_text_box(float x, float y, float width, float height, int font_size, RUI_COLOR text_color, RUI_COLOR background_color, const char *placeholder) {
-    TextBox text_box = {0};
-    text_box.x = x;
-    text_box.y = y;
-    text_box.textbox_bounds = (rui_rect){ text_box.x,text_box.y,width,height };
-    text_box.font_size = font_size;
-    text_box.text_color = text_color;
-    text_box.background_color = background_color;
-    text_box.line_count = 1;  // Start with one line
-    text_box.current_line = 0;
-    text_box.current_pos = 0;
-    text_box.active = false;
-    text_box.placeholder = placeholder;
-    text_box.placeholder_color = COLOR_LIGHTGRAY;
-    memset(text_box.textbox_text, 0, sizeof(text_box.textbox_text)); // Initialize text array with empty strings
-    return text_box;
+int rui_text_line_count(const rui_text_buffer *buffer) {
+    return 1 + buffer->line_gap_start + (buffer->line_capacity - buffer->line_gap_end);
 }
 
-// Draws the multiline text box and handles cursor blinking
-void render_text_box(TextBox *text_box) {
-	// Convert rui_rect to Raylib Rectangle
-	Rectangle raylibRect = toRaylibRectangle(text_box->textbox_bounds);
-    draw_rectangle_from_rect(raylibRect, text_box->background_color);// Draw background
-    draw_rectangle_lines(text_box->textbox_bounds.x, text_box->textbox_bounds.y, text_box->textbox_bounds.width, text_box->textbox_bounds.height, COLOR_DARKGRAY);// Draw border
+char rui_text_char_at(const rui_text_buffer *buffer, int position) {
+    if (position < buffer->gap_start) return buffer->data[position];
+    return buffer->data[position + (buffer->gap_end - buffer->gap_start)];
+}
 
-    bool is_empty = (text_box->line_count == 1 && strlen(text_box->textbox_text[0]) == 0);
+// Codepoint starting at a byte offset, which may straddle the gap; its length in bytes goes to *size
+int rui_text_codepoint_at(const rui_text_buffer *buffer, int position, int *size) {
+    char bytes[5] = {0};
+    *size = 1;
+    bytes[0] = rui_text_char_at(buffer, position);
+    if ((unsigned char)bytes[0] < 0x80) return bytes[0];
+    int length = rui_text_length(buffer);
+    for (int i = 1; i < 4 && position + i < length; i++) bytes[i] = rui_text_char_at(buffer, position + i);
+    return GetCodepointNext(bytes, size);
+}
+
+// Start of the codepoint before or after a byte offset, skipping UTF-8 continuation bytes
+int rui_text_previous(const rui_text_buffer *buffer, int position) {
+    if (position > 0) position--;
+    while (position > 0 && ((unsigned char)rui_text_char_at(buffer, position) & 0xC0) == 0x80) position--;
+    return position;
+}
+
+int rui_text_next(const rui_text_buffer *buffer, int position) {
+    int length = rui_text_length(buffer);
+    if (position < length) position++;
+    while (position < length && ((unsigned char)rui_text_char_at(buffer, position) & 0xC0) == 0x80) position++;
+    return position;
+}
+
+// Offset of the first byte of a line
+int rui_text_line_start(const rui_text_buffer *buffer, int line) {
+    if (line <= 0) return 0;
+    if (line - 1 < buffer->line_gap_start) return buffer->lines[line - 1];
+    return rui_text_length(buffer) - buffer->lines[buffer->line_gap_end + (line - 1 - buffer->line_gap_start)];
+}
+
+// Offset of the end of a line, not counting its '\n'
+int rui_text_line_end(const rui_text_buffer *buffer, int line) {
+    if (line + 1 >= rui_text_line_count(buffer)) return rui_text_length(buffer);
+    return rui_text_line_start(buffer, line + 1) - 1;
+}
+
+// Line containing a byte offset, by binary search over the line starts
+int rui_text_line_of(const rui_text_buffer *buffer, int position) {
+    int low = 0, high = rui_text_line_count(buffer) - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (rui_text_line_start(buffer, mid) <= position) low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+// Make room for `bytes` more bytes and `lines` more line starts
+static void rui_text_reserve(rui_text_buffer *buffer, int bytes, int lines) {
+    int gap = buffer->gap_end - buffer->gap_start;
+    if (gap < bytes + 1) {  // one spare byte for the terminator of rui_text_view
+        int capacity = buffer->capacity ? buffer->capacity : 64;
+        while (capacity - rui_text_length(buffer) < bytes + 1) capacity *= 2;
+        int after = buffer->capacity - buffer->gap_end;
+        buffer->data = realloc(buffer->data, capacity);
+        memmove(buffer->data + capacity - after, buffer->data + buffer->gap_end, after);
+        buffer->gap_end = capacity - after;
+        buffer->capacity = capacity;
+    }
+    if (buffer->line_gap_end - buffer->line_gap_start < lines) {
+        int capacity = buffer->line_capacity ? buffer->line_capacity : 16;
+        int used = rui_text_line_count(buffer) - 1;
+        while (capacity - used < lines) capacity *= 2;
+        int after = buffer->line_capacity - buffer->line_gap_end;
+        buffer->lines = realloc(buffer->lines, capacity * sizeof(int));
+        memmove(buffer->lines + capacity - after, buffer->lines + buffer->line_gap_end, after * sizeof(int));
+        buffer->line_gap_end = capacity - after;
+        buffer->line_capacity = capacity;
+    }
+}
+
+// Put the cursor (the gap) at a byte offset
+void rui_text_move_gap(rui_text_buffer *buffer, int position) {
+    int length = rui_text_length(buffer);
+    if (position < 0) position = 0;
+    if (position > length) position = length;
+    if (buffer->capacity == 0) return;
+    if (position < buffer->gap_start) {
+        int count = buffer->gap_start - position;
+        memmove(buffer->data + buffer->gap_end - count, buffer->data + position, count);
+        buffer->gap_start -= count;
+        buffer->gap_end -= count;
+        while (buffer->line_gap_start > 0 && buffer->lines[buffer->line_gap_start - 1] > position) {
+            buffer->lines[--buffer->line_gap_end] = length - buffer->lines[--buffer->line_gap_start];
+        }
+    } else if (position > buffer->gap_start) {
+        int count = position - buffer->gap_start;
+        memmove(buffer->data + buffer->gap_start, buffer->data + buffer->gap_end, count);
+        buffer->gap_start += count;
+        buffer->gap_end += count;
+        while (buffer->line_gap_end < buffer->line_capacity && length - buffer->lines[buffer->line_gap_end] <= position) {
+            buffer->lines[buffer->line_gap_start++] = length - buffer->lines[buffer->line_gap_end++];
+        }
+    }
+}
+
+// Insert bytes at the cursor and move the cursor past them
+void rui_text_insert(rui_text_buffer *buffer, const char *text, int count) {
+    int newlines = 0;
+    for (int i = 0; i < count; i++) newlines += text[i] == '\n';
+    rui_text_reserve(buffer, count, newlines);
+    for (int i = 0; i < count; i++) {
+        buffer->data[buffer->gap_start++] = text[i];
+        if (text[i] == '\n') buffer->lines[buffer->line_gap_start++] = buffer->gap_start;
+    }
+}
+
+// Delete up to `count` bytes before the cursor (backspace)
+void rui_text_delete_before(rui_text_buffer *buffer, int count) {
+    if (count > buffer->gap_start) count = buffer->gap_start;
+    for (int i = 0; i < count; i++) {
+        if (buffer->data[--buffer->gap_start] == '\n') buffer->line_gap_start--;
+    }
+}
+
+// Delete up to `count` bytes after the cursor (delete key)
+void rui_text_delete_after(rui_text_buffer *buffer, int count) {
+    if (count > buffer->capacity - buffer->gap_end) count = buffer->capacity - buffer->gap_end;
+    for (int i = 0; i < count; i++) {
+        if (buffer->data[buffer->gap_end++] == '\n') buffer->line_gap_end++;
+    }
+}
+
+// The whole text as one NUL-terminated string, without copying it. The gap is
+// moved to the end (free if it is already there) and stays there until the
+// next edit; the view is valid until then.
+const char *rui_text_view(rui_text_buffer *buffer) {
+    if (buffer->capacity == 0) return "";
+    rui_text_move_gap(buffer, rui_text_length(buffer));
+    buffer->data[buffer->gap_start] = '\0';
+    return buffer->data;
+}
+
+// A run of text that is not NUL-terminated
+typedef struct {
+    const char *text;
+    int length;
+} TextSlice;
+
+// The whole text as at most two slices, before and after the gap, without
+// copying or moving anything. Returns the number of slices.
+int rui_text_slices(const rui_text_buffer *buffer, TextSlice slices[2]) {
+    int count = 0;
+    if (buffer->gap_start > 0) slices[count++] = (TextSlice){ buffer->data, buffer->gap_start };
+    if (buffer->gap_end < buffer->capacity) slices[count++] = (TextSlice){ buffer->data + buffer->gap_end, buffer->capacity - buffer->gap_end };
+    return count;
+}
+
+// Copy the text into `out`, cut to size - 1 bytes and NUL-terminated. Returns the full length.
+int rui_text_copy(const rui_text_buffer *buffer, char *out, int size) {
+    int length = rui_text_length(buffer);
+    if (size <= 0) return length;
+    TextSlice slices[2];
+    int count = rui_text_slices(buffer, slices);
+    int written = 0;
+    for (int i = 0; i < count && written < size - 1; i++) {
+        int n = slices[i].length < size - 1 - written ? slices[i].length : size - 1 - written;
+        memcpy(out + written, slices[i].text, n);
+        written += n;
+    }
+    out[written] = '\0';
+    return length;
+}
+
+void rui_text_free(rui_text_buffer *buffer) {
+    free(buffer->data);
+    free(buffer->lines);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+//--------------------------- Text Box Struct ---------------------------
+// Lines are word-wrapped into rows. The first row of every line is kept in a
+// gapped array like the text's line starts: rows before the gap counted from
+// the top, rows after it from the bottom, so rewrapping the lines an edit
+// touched leaves the rest of the document's rows valid.
+
+typedef struct {
+    int *rows;            // rows[0..gap_start) from the top, rows[gap_end..capacity) from the bottom
+    int capacity;
+    int gap_start;        // also the number of lines before the gap
+    int gap_end;
+    int row_count;
+    bool stale;           // Lines [stale_first, line count - stale_tail) need rewrapping
+    int stale_first;
+    int stale_tail;
+    float width;          // Box width and font size the rows were wrapped for
+    int font_size;
+} rui_wrap_index;
+
+typedef struct {
+    rui_rect textbox_bounds;
+    rui_text_buffer text;   // Contents
+    rui_wrap_index wrap;    // Rows of each line
+    int cursor;             // Byte offset of the cursor in text
+    int line_count;
+    RUI_COLOR background_color;
+    bool active;
+    int current_line;       // Line of the cursor
+    int current_pos;        // Byte offset of the cursor within current_line
+    int scroll_row;         // First visible row
+    const char *placeholder;
+    RUI_COLOR placeholder_color;
+    int font_size;
+    RUI_COLOR text_color;
+    float x,y;
+    bool cursor_visible;  // Blink state, updated by update_text_box
+    rui_hit hit;          // Entry in a hit grid, see track_text_box
+} TextBox;
+
+// Initialize a multiline text box with placeholder text
+TextBox create_text_box(float x, float y, float width, float height, int font_size, RUI_COLOR text_color, RUI_COLOR background_color, const char *placeholder) {
+    TextBox text_box = {0};
+    text_box.x = x;
+    text_box.y = y;
+    text_box.textbox_bounds = (rui_rect){ text_box.x,text_box.y,width,height };
+    text_box.font_size = font_size;
+    text_box.text_color = text_color;
+    text_box.background_color = background_color;
+    text_box.line_count = 1;  // Start with one line
+    text_box.current_line = 0;
+    text_box.current_pos = 0;
+    text_box.scroll_row = 0;
+    text_box.active = false;
+    text_box.placeholder = placeholder;
+    text_box.placeholder_color = COLOR_LIGHTGRAY;
+    text_box.cursor_visible = false;
+    return text_box;  // The text buffer is allocated on the first insertion, the wrap index on the first render
+}
+
+// Free the text of a text box
+void destroy_text_box(TextBox *text_box) {
+    rui_text_free(&text_box->text);
+    free(text_box->wrap.rows);
+    memset(&text_box->wrap, 0, sizeof(text_box->wrap));
+    text_box->line_count = 1;
+    text_box->cursor = text_box->current_line = text_box->current_pos = text_box->scroll_row = 0;
+}
+
+// Lines that fit in the box
+static int rui_text_box_visible_lines(const TextBox *text_box) {
+    int lines = (text_box->textbox_bounds.height - 5) / (text_box->font_size + 5);
+    return lines > 0 ? lines : 1;
+}
+
+// First row of a line; the line count gives the number of rows
+static int rui_wrap_first_row(const rui_wrap_index *wrap, int line) {
+    if (line < wrap->gap_start) return wrap->rows[line];
+    line += wrap->gap_end - wrap->gap_start;
+    return line < wrap->capacity ? wrap->row_count - wrap->rows[line] : wrap->row_count;
+}
+
+// Line containing a row, by binary search over the first rows
+static int rui_wrap_line_of_row(const rui_wrap_index *wrap, int row) {
+    int low = 0, high = wrap->gap_start + (wrap->capacity - wrap->gap_end) - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (rui_wrap_first_row(wrap, mid) <= row) low = mid;
+        else high = mid - 1;
+    }
+    return low;
+}
+
+// Put the gap of the wrap index before a line
+static void rui_wrap_move_gap(rui_wrap_index *wrap, int line) {
+    while (wrap->gap_start > line) {
+        wrap->gap_start--;
+        wrap->gap_end--;
+        wrap->rows[wrap->gap_end] = wrap->row_count - wrap->rows[wrap->gap_start];
+    }
+    while (wrap->gap_start < line && wrap->gap_end < wrap->capacity) {
+        wrap->rows[wrap->gap_start] = wrap->row_count - wrap->rows[wrap->gap_end];
+        wrap->gap_start++;
+        wrap->gap_end++;
+    }
+}
+
+// Note that the line at the gap is about to change or just changed, so the next wrap redoes it
+static void rui_text_box_touch(TextBox *text_box) {
+    rui_wrap_index *wrap = &text_box->wrap;
+    int line = text_box->text.line_gap_start;
+    int tail = rui_text_line_count(&text_box->text) - 1 - line;
+    if (!wrap->stale || line < wrap->stale_first) wrap->stale_first = line;
+    if (!wrap->stale || tail < wrap->stale_tail) wrap->stale_tail = tail;
+    wrap->stale = true;
+}
+
+// Width of bytes [from, to) of the text, which may straddle the gap
+static float rui_text_box_advance(const TextBox *text_box, int from, int to) {
+    float width = 0;
+    while (from < to) {
+        int size;
+        width += measure_glyph(rui_text_codepoint_at(&text_box->text, from, &size), text_box->font_size);
+        from += size;
+    }
+    return width;
+}
+
+// End of the row starting at `from` in a line ending at `end`: after the last
+// space that fits, else after the last character that fits. Spaces may hang
+// past the edge, and a row always takes at least one character.
+static int rui_text_box_row_end(const TextBox *text_box, int from, int end) {
+    float limit = text_box->textbox_bounds.width - 10;
+    float width = 0;
+    int position = from, space = from;
+    while (position < end) {
+        int size;
+        int codepoint = rui_text_codepoint_at(&text_box->text, position, &size);
+        float advance = measure_glyph(codepoint, text_box->font_size);
+        if (codepoint != ' ' && width + advance > limit && position > from) return space > from ? space : position;
+        width += advance;
+        position += size;
+        if (codepoint == ' ') space = position;
+    }
+    return end;
+}
+
+// Rows a line wraps into
+static int rui_text_box_line_rows(const TextBox *text_box, int line) {
+    int from = rui_text_line_start(&text_box->text, line), end = rui_text_line_end(&text_box->text, line);
+    int rows = 1;
+    while ((from = rui_text_box_row_end(text_box, from, end)) < end) rows++;
+    return rows;
+}
+
+// Rewrap the lines touched since the last call, or every line if the width or font size changed
+static void rui_text_box_wrap(TextBox *text_box) {
+    rui_wrap_index *wrap = &text_box->wrap;
+    if (wrap->width != text_box->textbox_bounds.width || wrap->font_size != text_box->font_size) {
+        wrap->width = text_box->textbox_bounds.width;
+        wrap->font_size = text_box->font_size;
+        wrap->stale = true;
+        wrap->stale_first = wrap->stale_tail = 0;
+    }
+    if (!wrap->stale) return;
+    wrap->stale = false;
+
+    // Drop the rows of the stale lines. The lines after them keep their rows counted from the bottom.
+    int old_lines = wrap->gap_start + (wrap->capacity - wrap->gap_end);
+    int first = wrap->stale_first, tail = wrap->stale_tail;
+    rui_wrap_move_gap(wrap, first);
+    int row = rui_wrap_first_row(wrap, first);
+    int rows_after = wrap->row_count - rui_wrap_first_row(wrap, old_lines - tail);
+    wrap->gap_end += old_lines - tail - first;
+
+    int last = rui_text_line_count(&text_box->text) - tail;
+    if (wrap->gap_end - wrap->gap_start < last - first) {
+        int capacity = wrap->capacity ? wrap->capacity : 16;
+        int after = wrap->capacity - wrap->gap_end;
+        while (capacity - after - wrap->gap_start < last - first) capacity *= 2;
+        wrap->rows = realloc(wrap->rows, capacity * sizeof(int));
+        memmove(wrap->rows + capacity - after, wrap->rows + wrap->gap_end, after * sizeof(int));
+        wrap->gap_end = capacity - after;
+        wrap->capacity = capacity;
+    }
+    for (int line = first; line < last; line++) {
+        wrap->rows[wrap->gap_start++] = row;
+        row += rui_text_box_line_rows(text_box, line);
+    }
+    wrap->row_count = row + rows_after;
+}
+
+// Row containing a byte offset, and where that row starts. An offset where a line wraps belongs to the row after it.
+static int rui_text_box_row_of(const TextBox *text_box, int position, int *row_start) {
+    int line = rui_text_line_of(&text_box->text, position);
+    int end = rui_text_line_end(&text_box->text, line);
+    int row = rui_wrap_first_row(&text_box->wrap, line);
+    int from = rui_text_line_start(&text_box->text, line);
+    for (int next; (next = rui_text_box_row_end(text_box, from, end)) <= position && next < end; from = next) row++;
+    *row_start = from;
+    return row;
+}
+
+// Byte range [*start, *end) of a row
+static void rui_text_box_row_range(const TextBox *text_box, int row, int *start, int *end) {
+    int line = rui_wrap_line_of_row(&text_box->wrap, row);
+    int line_end = rui_text_line_end(&text_box->text, line);
+    int from = rui_text_line_start(&text_box->text, line);
+    for (int i = rui_wrap_first_row(&text_box->wrap, line); i < row; i++) from = rui_text_box_row_end(text_box, from, line_end);
+    *start = from;
+    *end = rui_text_box_row_end(text_box, from, line_end);
+}
+
+// Byte offset in the row [start, end) nearest to `x` pixels from its left edge
+static int rui_text_box_position_at(const TextBox *text_box, int start, int end, float x) {
+    const rui_text_buffer *text = &text_box->text;
+    // An offset at the end of a wrapped row would land on the next row
+    bool wrapped = end < rui_text_length(text) && rui_text_char_at(text, end) != '\n';
+    float pen = 0;
+    int position = start;
+    while (position < end) {
+        int size;
+        float advance = measure_glyph(rui_text_codepoint_at(text, position, &size), text_box->font_size);
+        if (pen + advance / 2 > x || (wrapped && position + size == end)) break;
+        pen += advance;
+        position += size;
+    }
+    return position;
+}
+
+// Move the gap to the cursor before editing there
+static rui_text_buffer *rui_text_box_edit(TextBox *text_box) {
+    rui_text_move_gap(&text_box->text, text_box->cursor);
+    rui_text_box_touch(text_box);
+    return &text_box->text;
+}
+
+// Refresh the cursor fields and the wrap after an edit or a cursor move at the gap, and scroll to the cursor
+static void rui_text_box_sync(TextBox *text_box) {
+    text_box->cursor = text_box->text.gap_start;
+    text_box->line_count = rui_text_line_count(&text_box->text);
+    text_box->current_line = text_box->text.line_gap_start;
+    text_box->current_pos = text_box->text.gap_start - rui_text_line_start(&text_box->text, text_box->current_line);
+    rui_text_box_wrap(text_box);
+    int row_start;
+    int row = rui_text_box_row_of(text_box, text_box->cursor, &row_start);
+    int visible = rui_text_box_visible_lines(text_box);
+    if (row < text_box->scroll_row) text_box->scroll_row = row;
+    if (row >= text_box->scroll_row + visible) text_box->scroll_row = row - visible + 1;
+}
+
+// Replace the contents of a text box and put the cursor at the end
+void set_text_box_text(TextBox *text_box, const char *text) {
+    rui_text_free(&text_box->text);
+    rui_text_insert(&text_box->text, text, strlen(text));
+    text_box->wrap.stale = true;
+    text_box->wrap.stale_first = text_box->wrap.stale_tail = 0;
+    rui_text_box_sync(text_box);
+    damage_rect(toRaylibRectangle(text_box->textbox_bounds));
+}
+
+// Draw bytes [from, to) of the text, which may straddle the gap, in chunks that stop at the box's right edge
+static void rui_text_box_draw_range(TextBox *text_box, int from, int to, int x, int y) {
+    char chunk[256];
+    float limit = text_box->textbox_bounds.x + text_box->textbox_bounds.width - 5;
+    float pen = x;
+    while (from < to && pen < limit) {
+        int count = 0;
+        while (from + count < to && count < (int)sizeof(chunk)) {
+            chunk[count] = rui_text_char_at(&text_box->text, from + count);
+            count++;
+        }
+        if (from + count < to) {
+            // The chunk is full: leave its last, possibly cut, codepoint for the next one
+            while (count > 1 && (chunk[count - 1] & 0xC0) == 0x80) count--;
+            if (count > 1) count--;
+        }
+        // Only as many codepoints as can be seen
+        int visible = 0;
+        float width = pen;
+        while (visible < count && width < limit) {
+            int size = 1;
+            int codepoint = (unsigned char)chunk[visible];
+            if (codepoint >= 0x80) codepoint = GetCodepointNext(chunk + visible, &size);
+            width += measure_glyph(codepoint, text_box->font_size);
+            visible += size;
+        }
+        draw_text_n(chunk, visible, pen, y, text_box->font_size, text_box->text_color);
+        pen = width;
+        from += visible;
+    }
+}
+
+// Draws the multiline text box and handles cursor blinking
+void render_text_box(TextBox *text_box) {
+	// Convert rui_rect to Raylib Rectangle
+	Rectangle raylibRect = toRaylibRectangle(text_box->textbox_bounds);
+    if (!is_damaged(raylibRect)) return;
+    draw_rectangle_from_rect(raylibRect, text_box->background_color);// Draw background
+    draw_rectangle_lines(text_box->textbox_bounds.x, text_box->textbox_bounds.y, text_box->textbox_bounds.width, text_box->textbox_bounds.height, COLOR_DARKGRAY);// Draw border
+
+    bool is_empty = rui_text_length(&text_box->text) == 0;
 
     // If text box is empty and not active, show placeholder text
     if (is_empty && !text_box->active) {
             draw_text(text_box->placeholder, text_box->textbox_bounds.x + 5, text_box->textbox_bounds.y + 5, text_box->font_size, text_box->placeholder_color);
     } else {
-        // Draw each line of text
-        for (int i = 0; i < text_box->line_count; i++) {
-            int y_offset = i * (text_box->font_size + 5); // Adjust line spacing
-            draw_text(text_box->textbox_text[i], text_box->textbox_bounds.x + 5, text_box->textbox_bounds.y + y_offset + 5, text_box->font_size, text_box->text_color);
+        rui_text_box_wrap(text_box);  // Rewraps everything only if the box was resized
+        int visible = rui_text_box_visible_lines(text_box);
+        if (text_box->scroll_row >= text_box->wrap.row_count) text_box->scroll_row = text_box->wrap.row_count - 1;
+
+        // Draw the rows that fit in the box, starting from the line holding the first one
+        rui_text_buffer *text = &text_box->text;
+        int lines = rui_text_line_count(text);
+        int line = rui_wrap_line_of_row(&text_box->wrap, text_box->scroll_row);
+        int row = rui_wrap_first_row(&text_box->wrap, line);
+        int from = rui_text_line_start(text, line), end = rui_text_line_end(text, line);
+        while (row < text_box->scroll_row + visible && line < lines) {
+            int to = rui_text_box_row_end(text_box, from, end);
+            if (row >= text_box->scroll_row) {
+                int y_offset = (row - text_box->scroll_row) * (text_box->font_size + 5); // Adjust line spacing
+                rui_text_box_draw_range(text_box, from, to, text_box->textbox_bounds.x + 5, text_box->textbox_bounds.y + y_offset + 5);
+            }
+            row++;
+            if (to < end) {
+                from = to;
+            } else if (++line < lines) {
+                from = rui_text_line_start(text, line);
+                end = rui_text_line_end(text, line);
+            }
         }
 
         // Draw blinking cursor if active
-        if (text_box->active && text_box->current_line < MAX_LINES) {
-            int cursor_x = text_box->textbox_bounds.x + 5 + MeasureText(text_box->textbox_text[text_box->current_line], text_box->font_size);
-            int cursor_y = text_box->textbox_bounds.y + (text_box->current_line * (text_box->font_size + 5)) + 5;
-            if ((GetTime() * 2.0f) - (int)(GetTime() * 2.0f) < 0.5f) {  // Blinking effect
+        if (text_box->active) {
+            int row_start;
+            int cursor_row = rui_text_box_row_of(text_box, text_box->cursor, &row_start);
+            int cursor_x = text_box->textbox_bounds.x + 5 + rui_text_box_advance(text_box, row_start, text_box->cursor);
+            int cursor_y = text_box->textbox_bounds.y + ((cursor_row - text_box->scroll_row) * (text_box->font_size + 5)) + 5;
+            bool in_view = cursor_row >= text_box->scroll_row && cursor_row < text_box->scroll_row + visible;
+            if (text_box->cursor_visible && in_view) {  // Blinking effect
                 // DrawRectangle(cursor_x, cursor_y, 2, text_box->font_size, text_box->text_color);
                 draw_rectangle(cursor_x, cursor_y, 2, text_box->font_size, text_box->text_color);
             }
@@ -380,182 +1845,427 @@ void render_text_box(TextBox *text_box) {
     }
 }
 
-// Updates the multiline text box with user input and handles automatic line wrapping
-void update_text_box(TextBox *text_box) {
+// Updates the multiline text box with user input. Long lines wrap at word boundaries when drawn.
+void update_text_box(TextBox *text_box, const rui_input *input) {
+    bool changed = false;
     if (text_box->active) {
-        int key = GetCharPressed();
-
-        while (key > 0) {
-            // Check for printable characters and prevent overflow
-            if (key >= 32 && key <= 125) {
-                int text_width = MeasureText(text_box->textbox_text[text_box->current_line], text_box->font_size);
-                
-                // Check if adding the character would exceed the box width
-                if (text_width + MeasureText("A", text_box->font_size) >= text_box->textbox_bounds.width - 10 && text_box->current_line < MAX_LINES - 1) {
-                    // Move to the next line if current line width exceeds bounds
-                    text_box->current_line++;
-                    text_box->line_count++;
-                    text_box->current_pos = 0;
-                }
-
-                // Add the character to the current line if within bounds
-                if (text_box->current_pos < MAX_LINE_LENGTH - 1) {
-                    text_box->textbox_text[text_box->current_line][text_box->current_pos] = (char)key;
-                    text_box->current_pos++;
-                    text_box->textbox_text[text_box->current_line][text_box->current_pos] = '\0';  // Null-terminate the string
+        // The frame's keyboard events in one pass, with one re-wrap at the end
+        rui_text_buffer *text = NULL;
+        for (int i = 0; i < input->event_count; i++) {
+            const rui_key_event *event = &input->events[i];
+            if (event->type == RUI_KEY_CHAR) {
+                // A run of characters goes in with a single insertion
+                char typed[RUI_MAX_INPUT_EVENTS];
+                int typed_count = 0;
+                for (; i < input->event_count && input->events[i].type == RUI_KEY_CHAR; i++) {
+                    int key = input->events[i].code;
+                    // Printable characters, and new lines
+                    if ((key >= 32 && key <= 125) || key == '\n') typed[typed_count++] = (char)key;
                 }
-            } else if (key == KEY_ENTER || key == '\n') { // Move to a new line on Enter key
-                if (text_box->line_count < MAX_LINES) {
-                    text_box->current_line++;
-                    text_box->line_count++;
-                    text_box->current_pos = 0;
+                i--;
+                if (typed_count == 0) continue;
+                if (!text) text = rui_text_box_edit(text_box);
+                rui_text_insert(text, typed, typed_count);
+                rui_text_box_touch(text_box);
+                changed = true;
+                continue;
+            }
+            if (event->type != RUI_KEY_DOWN && event->type != RUI_KEY_REPEAT) continue;
+            switch (event->code) {
+            case KEY_ENTER: case KEY_BACKSPACE: case KEY_DELETE:
+            case KEY_LEFT: case KEY_RIGHT: case KEY_HOME: case KEY_END: case KEY_UP: case KEY_DOWN:
+                break;
+            default:
+                continue;
+            }
+            if (!text) text = rui_text_box_edit(text_box);
+            changed = true;
+            switch (event->code) {
+            case KEY_ENTER:
+                rui_text_insert(text, "\n", 1);
+                rui_text_box_touch(text_box);
+                break;
+            case KEY_BACKSPACE:
+                rui_text_delete_before(text, text->gap_start - rui_text_previous(text, text->gap_start));
+                rui_text_box_touch(text_box);
+                break;
+            case KEY_DELETE:
+                rui_text_delete_after(text, rui_text_next(text, text->gap_start) - text->gap_start);
+                rui_text_box_touch(text_box);
+                break;
+            case KEY_LEFT: rui_text_move_gap(text, rui_text_previous(text, text->gap_start)); break;
+            case KEY_RIGHT: rui_text_move_gap(text, rui_text_next(text, text->gap_start)); break;
+            case KEY_HOME: rui_text_move_gap(text, rui_text_line_start(text, text->line_gap_start)); break;
+            case KEY_END: rui_text_move_gap(text, rui_text_line_end(text, text->line_gap_start)); break;
+            case KEY_UP:
+            case KEY_DOWN: {
+                // Nearest position to the cursor's x on the row above or below
+                rui_text_box_wrap(text_box);
+                int start, end;
+                int row = rui_text_box_row_of(text_box, text->gap_start, &start);
+                float x = rui_text_box_advance(text_box, start, text->gap_start);
+                row += event->code == KEY_DOWN ? 1 : -1;
+                if (row >= 0 && row < text_box->wrap.row_count) {
+                    rui_text_box_row_range(text_box, row, &start, &end);
+                    rui_text_move_gap(text, rui_text_box_position_at(text_box, start, end, x));
                 }
+                break;
             }
-            key = GetCharPressed(); // Check for next character
-        }
-
-        // Handle backspace
-        if (IsKeyPressed(KEY_BACKSPACE)) {
-            if (text_box->current_pos > 0) {
-                text_box->current_pos--;
-                text_box->textbox_text[text_box->current_line][text_box->current_pos] = '\0';
-            } else if (text_box->current_line > 0) {
-                // Move back to the previous line if current line is empty
-                text_box->current_line--;
-                text_box->current_pos = strlen(text_box->textbox_text[text_box->current_line]);
             }
         }
+        if (changed) rui_text_box_sync(text_box);
     }
 
     // Activate or deactivate the text box on mouse click
     Rectangle raylibRect = toRaylibRectangle(text_box->textbox_bounds);
 
-    if (CheckCollisionPointRec(GetMousePosition(), raylibRect) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    bool was_active = text_box->active;
+    if (rui_hit_test(&text_box->hit, input->mouse, raylibRect) && input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
         text_box->active = true;
-    } else if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    } else if (input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
         text_box->active = false;
     }
-}
-// func to get text
-char* get_text_box_content(TextBox *text_box) {
-    static char full_text[MAX_LINES * MAX_LINE_LENGTH] = { 0 }; // Static buffer to store concatenated text
-    memset(full_text, 0, sizeof(full_text)); // Clear previous content
-    
-    for (int i = 0; i < text_box->line_count; i++) {
-        strcat(full_text, text_box->textbox_text[i]);
-        if (i < text_box->line_count - 1) {
-            strcat(full_text, "\n"); // Add newline between lines
-        }
+
+    bool cursor_visible = text_box->active && rui_cursor_blink_on(input);
+    if (text_box->active) rui_request_blink_frame(input);
+    if (changed || text_box->active != was_active || cursor_visible != text_box->cursor_visible) {
+        text_box->cursor_visible = cursor_visible;
+        damage_rect(raylibRect);
     }
-    
-    return full_text;
+}
+// func to get text: a view of the box's own storage, valid until the box is next edited.
+// The first call after an edit moves the text's gap; the copy and slice functions below never change the box.
+const char* get_text_box_content(TextBox *text_box) {
+    return rui_text_view(&text_box->text);
+}
+
+// Length of the text in bytes, not counting a terminator
+int get_text_box_length(const TextBox *text_box) {
+    return rui_text_length(&text_box->text);
+}
+
+// Copy the text into a caller's buffer, cut to size - 1 bytes and NUL-terminated.
+// Returns the full length, so size get_text_box_length() + 1 always fits.
+int copy_text_box_content(const TextBox *text_box, char *buffer, int size) {
+    return rui_text_copy(&text_box->text, buffer, size);
+}
+
+// The text as at most two slices in order, pointing into the box without copying;
+// valid until the box is next edited. Returns the number of slices.
+int get_text_box_slices(const TextBox *text_box, TextSlice slices[2]) {
+    return rui_text_slices(&text_box->text, slices);
 }
 
 void update_textbox_position(TextBox *text_box, MenuWindow *menu) {
+    Rectangle old_bounds = toRaylibRectangle(text_box->textbox_bounds);
     // Adjust button position relative to the menu
     text_box->textbox_bounds.x = menu->bounds.x + text_box->x;
     text_box->textbox_bounds.y = menu->bounds.y + text_box->y;
+    rui_damage_child_move(menu, old_bounds, toRaylibRectangle(text_box->textbox_bounds));
+    rui_hit_move(&text_box->hit, toRaylibRectangle(text_box->textbox_bounds));
+}
+
+// Hit test the text box through a grid, see track_button
+void track_text_box(rui_hit_grid *grid, TextBox *text_box, int z) {
+    text_box->hit = rui_hit_track(grid, toRaylibRectangle(text_box->textbox_bounds), z);
+}
+
+void untrack_text_box(TextBox *text_box) {
+    rui_hit_untrack(&text_box->hit);
 }
 //--------------------------- Text Entry Struct ---------------------------
 
+// The text and its pen positions live on the heap and grow with the text, by
+// doubling, up to MAX_TEXT_LENGTH bytes. An entry owns them: copy it only
+// before anything is typed, and free them with destroy_text_entry.
+
 typedef struct {
     rui_rect textentry_bounds;
-    char text[MAX_TEXT_LENGTH];
+    char *text;
+    int length;                           // Bytes in text, not counting the terminator
+    int capacity;                         // Bytes allocated for text, and floats for text_x; 0 until the first insertion
+    float *text_x;                        // Pen x before each byte of text (prefix sum of glyph advances)
     int cursor_position;
-    int text_offset;
+    int text_offset;                      // First visible byte
     bool active;
     int font_size;
     RUI_COLOR text_color;
     RUI_COLOR background_color;
     float x, y;
+    bool cursor_visible;  // Blink state, updated by update_text_entry
+    rui_hit hit;          // Entry in a hit grid, see track_text_entry
 } TextEntry;
 
+// What an entry shows before its text is allocated; never written
+static char rui_entry_no_text[1] = "";
+static float rui_entry_no_x[1] = { 0 };
+
+// Initialize a single-line text entry box in place. Nothing is allocated
+// until the first insertion.
+void init_text_entry(TextEntry *entry, float x, float y, float width, float height, int font_size, RUI_COLOR text_color, RUI_COLOR background_color) {
+    entry->x = x;
+    entry->y = y;
+    entry->textentry_bounds = (rui_rect){ x,y,width,height };
+    entry->font_size = font_size;
+    entry->text_color = text_color;
+    entry->background_color = background_color;
+    entry->active = false;
+    entry->length = 0;
+    entry->cursor_position = 0;
+    entry->text_offset = 0;
+    entry->text = rui_entry_no_text;
+    entry->text_x = rui_entry_no_x;
+    entry->capacity = 0;
+    entry->cursor_visible = false;
+    entry->hit = (rui_hit){ NULL, 0 };
+}
+
 // Initialize a single-line text entry box
 TextEntry create_text_entry(float x, float y, float width, float height, int font_size, RUI_COLOR text_color, RUI_COLOR background_color) {
 	TextEntry entry = {0};
-	entry.x = x;
-	entry.y = y;
-    entry.textentry_bounds = (rui_rect){ x,y,width,height };
-    entry.font_size = font_size;
-    entry.text_color = text_color;
-    entry.background_color = background_color;
-    entry.active = false;
-    entry.cursor_position = 0;
-    entry.text_offset = 0;
-    memset(entry.text, 0, MAX_TEXT_LENGTH); // Initialize text with empty characters
+    init_text_entry(&entry, x, y, width, height, font_size, text_color, background_color);
     return entry;
 }
 
+// Free the text of an entry; it is empty afterwards and may be used again
+void destroy_text_entry(TextEntry *entry) {
+    if (entry->capacity > 0) {
+        free(entry->text);
+        free(entry->text_x);
+    }
+    entry->text = rui_entry_no_text;
+    entry->text_x = rui_entry_no_x;
+    entry->capacity = 0;
+    entry->length = entry->cursor_position = entry->text_offset = 0;
+}
+
+// Room for `length` bytes of text; false when the heap or MAX_TEXT_LENGTH says no
+static bool rui_entry_reserve(TextEntry *entry, int length) {
+    if (length < entry->capacity) return true;
+    if (length >= MAX_TEXT_LENGTH) return false;
+    int capacity = entry->capacity > 0 ? entry->capacity : 16;
+    while (capacity <= length) capacity *= 2;
+    if (capacity > MAX_TEXT_LENGTH) capacity = MAX_TEXT_LENGTH;
+    char *text = malloc(capacity);
+    float *text_x = malloc(capacity * sizeof(float));
+    if (!text || !text_x) {
+        TraceLog(LOG_WARNING, "RUI: could not grow a text entry to %d bytes", capacity);
+        free(text);
+        free(text_x);
+        return false;
+    }
+    memcpy(text, entry->text, entry->length + 1);
+    memcpy(text_x, entry->text_x, (entry->length + 1) * sizeof(float));
+    if (entry->capacity > 0) {
+        free(entry->text);
+        free(entry->text_x);
+    }
+    entry->text = text;
+    entry->text_x = text_x;
+    entry->capacity = capacity;
+    return true;
+}
+
+// UTF-8 continuation bytes are not positions the cursor can be at
+static bool rui_entry_inside_codepoint(const TextEntry *entry, int position) {
+    return position > 0 && position < entry->length && ((unsigned char)entry->text[position] & 0xC0) == 0x80;
+}
+
+// Cursor position one codepoint before or after `position`
+static int rui_entry_previous(const TextEntry *entry, int position) {
+    if (position > 0) position--;
+    while (rui_entry_inside_codepoint(entry, position)) position--;
+    return position;
+}
+
+static int rui_entry_next(const TextEntry *entry, int position) {
+    if (position < entry->length) position++;
+    while (rui_entry_inside_codepoint(entry, position)) position++;
+    return position;
+}
+
+// First codepoint boundary whose pen x is at least `x`; text_x never decreases, so this is a binary search
+static int rui_entry_boundary_at(const TextEntry *entry, float x) {
+    int low = 0, high = entry->length;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (entry->text_x[mid] < x) low = mid + 1;
+        else high = mid;
+    }
+    // The bytes of a codepoint share the x after it
+    while (rui_entry_inside_codepoint(entry, low)) low++;
+    return low;
+}
+
+// Width available for text inside the entry's padding
+static float rui_entry_inner_width(const TextEntry *entry) {
+    return entry->textentry_bounds.width - 10;
+}
+
+// Recompute the pen positions from byte `from` on, after an edit there
+static void rui_entry_reflow(TextEntry *entry, int from) {
+    measure_text_positions(entry->text + from, entry->length - from, entry->font_size, entry->text_x + from);
+}
+
+// Scroll so the cursor is visible, and use free space on the right after a deletion
+static void rui_entry_scroll(TextEntry *entry) {
+    float inner = rui_entry_inner_width(entry);
+    if (entry->text_offset > entry->cursor_position) entry->text_offset = entry->cursor_position;
+    int first = rui_entry_boundary_at(entry, entry->text_x[entry->cursor_position] - inner);
+    if (entry->text_offset < first) entry->text_offset = first;
+    first = rui_entry_boundary_at(entry, entry->text_x[entry->length] - inner);
+    if (entry->text_offset > first) entry->text_offset = first;
+}
+
+// Insert `count` bytes at the cursor, dropping what does not fit in MAX_TEXT_LENGTH.
+// Like rui_entry_erase, returns the first byte that changed, or -1 for none;
+// the caller reflows from there once it is done editing.
+static int rui_entry_insert(TextEntry *entry, const char *chars, int count) {
+    int at = entry->cursor_position;
+    if (count > MAX_TEXT_LENGTH - 1 - entry->length) count = MAX_TEXT_LENGTH - 1 - entry->length;
+    if (count <= 0 || !rui_entry_reserve(entry, entry->length + count)) return -1;
+    memmove(entry->text + at + count, entry->text + at, entry->length - at + 1);  // with the terminator
+    memcpy(entry->text + at, chars, count);
+    entry->length += count;
+    entry->cursor_position += count;
+    return at;
+}
+
+// Remove `count` bytes starting at `at`
+static int rui_entry_erase(TextEntry *entry, int at, int count) {
+    memmove(entry->text + at, entry->text + at + count, entry->length - at - count + 1);
+    entry->length -= count;
+    if (entry->cursor_position >= at + count) entry->cursor_position -= count;
+    else if (entry->cursor_position > at) entry->cursor_position = at;
+    return at;
+}
+
+// Replace the text of an entry and put the cursor at its end
+void set_text_entry_text(TextEntry *entry, const char *text) {
+    entry->length = 0;
+    entry->cursor_position = 0;
+    entry->text_offset = 0;
+    if (entry->capacity > 0) entry->text[0] = '\0';
+    rui_entry_insert(entry, text, strlen(text));
+    rui_entry_reflow(entry, 0);
+    rui_entry_scroll(entry);
+    damage_rect(toRaylibRectangle(entry->textentry_bounds));
+}
+
 // Draws the single-line text entry box and handles cursor blinking
 void render_text_entry(TextEntry *entry) {
 		// Convert rui_rect to Raylib Rectangle
 	Rectangle raylibRect = toRaylibRectangle(entry->textentry_bounds);
+    if (!is_damaged(raylibRect)) return;
     draw_rectangle_from_rect(raylibRect, entry->background_color); // Draw background
     draw_rectangle_lines(entry->textentry_bounds.x, entry->textentry_bounds.y, entry->textentry_bounds.width, entry->textentry_bounds.height, COLOR_DARKGRAY); // Draw border
 
-    // Calculate visible text starting from the text offset
-    char *visible_text = entry->text + entry->text_offset;
-    
-    draw_text(visible_text, entry->textentry_bounds.x + 5, entry->textentry_bounds.y + (entry->textentry_bounds.height - entry->font_size) / 2, entry->font_size, entry->text_color);
+    // Draw only the characters that fit, starting from the text offset
+    float start_x = entry->text_x[entry->text_offset];
+    int visible_end = rui_entry_boundary_at(entry, start_x + rui_entry_inner_width(entry));
+    if (entry->text_x[visible_end] > start_x + rui_entry_inner_width(entry) && visible_end > entry->text_offset) visible_end = rui_entry_previous(entry, visible_end);
+    int text_y = entry->textentry_bounds.y + (entry->textentry_bounds.height - entry->font_size) / 2;
+    draw_text_n(entry->text + entry->text_offset, visible_end - entry->text_offset, entry->textentry_bounds.x + 5, text_y, entry->font_size, entry->text_color);
 
     // Draw blinking cursor if active
     if (entry->active) {
-        int cursor_x = entry->textentry_bounds.x + 5 + MeasureText(visible_text, entry->font_size);
-        if ((GetTime() * 2.0f) - (int)(GetTime() * 2.0f) < 0.5f) { // Blinking effect
-            draw_rectangle(cursor_x, entry->textentry_bounds.y + (entry->textentry_bounds.height - entry->font_size) / 2, 2, entry->font_size, entry->text_color);
+        int cursor_x = entry->textentry_bounds.x + 5 + (entry->text_x[entry->cursor_position] - start_x);
+        if (entry->cursor_visible) { // Blinking effect
+            draw_rectangle(cursor_x, text_y, 2, entry->font_size, entry->text_color);
         }
     }
 }
 
 // Updates the text entry box with user input and handles text scrolling when full
-void update_text_entry(TextEntry *entry) {
+void update_text_entry(TextEntry *entry, const rui_input *input) {
+    bool changed = false;
     if (entry->active) {
-        int key = GetCharPressed();
-
-        while (key > 0) {
-            // Check for printable characters and prevent overflow
-            if (key >= 32 && key <= 125 && entry->cursor_position < MAX_TEXT_LENGTH - 1) {
-                entry->text[entry->cursor_position] = (char)key;
-                entry->cursor_position++;
-                entry->text[entry->cursor_position] = '\0';
-
-                // Calculate the text width and adjust the offset to keep text visible
-                int text_width = MeasureText(entry->text + entry->text_offset, entry->font_size);
-                if (text_width > entry->textentry_bounds.width - 10) {
-                    entry->text_offset++;
+        // The frame's keyboard events in one pass; the glyph positions are
+        // measured once at the end, from the first byte any event changed
+        int reflow_from = -1;
+        int old_cursor = entry->cursor_position;
+        for (int i = 0; i < input->event_count; i++) {
+            const rui_key_event *event = &input->events[i];
+            int at = -1;
+            if (event->type == RUI_KEY_CHAR) {
+                // A run of characters (typed or pasted) goes in with a single insertion
+                char typed[RUI_MAX_INPUT_EVENTS];
+                int typed_count = 0;
+                for (; i < input->event_count && input->events[i].type == RUI_KEY_CHAR; i++) {
+                    int key = input->events[i].code;
+                    // Check for printable characters
+                    if (key >= 32 && key <= 125) typed[typed_count++] = (char)key;
                 }
-            }
-            key = GetCharPressed();
-        }
-
-        // Handle backspace
-        if (IsKeyPressed(KEY_BACKSPACE)) {
-            if (entry->cursor_position > 0) {
-                entry->cursor_position--;
-                entry->text[entry->cursor_position] = '\0';
-
-                // Adjust the text offset if there’s extra space after deleting
-                int text_width = MeasureText(entry->text + entry->text_offset, entry->font_size);
-                if (text_width < entry->textentry_bounds.width - 10 && entry->text_offset > 0) {
-                    entry->text_offset--;
+                i--;
+                if (typed_count > 0) at = rui_entry_insert(entry, typed, typed_count);
+            } else if (event->type == RUI_KEY_DOWN || event->type == RUI_KEY_REPEAT) {
+                switch (event->code) {
+                case KEY_BACKSPACE: {
+                    int previous = rui_entry_previous(entry, entry->cursor_position);
+                    if (previous < entry->cursor_position) at = rui_entry_erase(entry, previous, entry->cursor_position - previous);
+                    break;
+                }
+                case KEY_DELETE: {
+                    int next = rui_entry_next(entry, entry->cursor_position);
+                    if (next > entry->cursor_position) at = rui_entry_erase(entry, entry->cursor_position, next - entry->cursor_position);
+                    break;
+                }
+                case KEY_LEFT: entry->cursor_position = rui_entry_previous(entry, entry->cursor_position); break;
+                case KEY_RIGHT: entry->cursor_position = rui_entry_next(entry, entry->cursor_position); break;
+                case KEY_HOME: entry->cursor_position = 0; break;
+                case KEY_END: entry->cursor_position = entry->length; break;
                 }
             }
+            if (at >= 0 && (reflow_from < 0 || at < reflow_from)) reflow_from = at;
+        }
+        if (reflow_from >= 0) {
+            rui_entry_reflow(entry, reflow_from);
+            changed = true;
         }
+        if (entry->cursor_position != old_cursor) changed = true;
     }
 
     // Activate or deactivate the text entry box on mouse click
 	Rectangle raylibRect = toRaylibRectangle(entry->textentry_bounds);// Convert rui_rect to Raylib Rectangle
 
-    if (CheckCollisionPointRec(GetMousePosition(),raylibRect) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    bool was_active = entry->active;
+    if (rui_hit_test(&entry->hit, input->mouse, raylibRect) && input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
         entry->active = true;
-    } else if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        // Put the cursor on the character boundary closest to the click
+        float click_x = input->mouse.x - (entry->textentry_bounds.x + 5) + entry->text_x[entry->text_offset];
+        int position = rui_entry_boundary_at(entry, click_x);
+        int previous = rui_entry_previous(entry, position);
+        if (previous < position && click_x - entry->text_x[previous] < entry->text_x[position] - click_x) position = previous;
+        if (position != entry->cursor_position) changed = true;
+        entry->cursor_position = position;
+    } else if (input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
         entry->active = false;
     }
+    if (changed) rui_entry_scroll(entry);
+
+    bool cursor_visible = entry->active && rui_cursor_blink_on(input);
+    if (entry->active) rui_request_blink_frame(input);
+    if (changed || entry->active != was_active || cursor_visible != entry->cursor_visible) {
+        entry->cursor_visible = cursor_visible;
+        damage_rect(raylibRect);
+    }
 }
 void update_entry_position(TextEntry *entry, MenuWindow *menu) {
+    Rectangle old_bounds = toRaylibRectangle(entry->textentry_bounds);
     // Adjust button position relative to the menu
     entry->textentry_bounds.x = menu->bounds.x + entry->x;
     entry->textentry_bounds.y = menu->bounds.y + entry->y;
+    rui_damage_child_move(menu, old_bounds, toRaylibRectangle(entry->textentry_bounds));
+    rui_hit_move(&entry->hit, toRaylibRectangle(entry->textentry_bounds));
+}
+
+// Hit test the text entry through a grid, see track_button
+void track_text_entry(rui_hit_grid *grid, TextEntry *entry, int z) {
+    entry->hit = rui_hit_track(grid, toRaylibRectangle(entry->textentry_bounds), z);
+}
+
+void untrack_text_entry(TextEntry *entry) {
+    rui_hit_untrack(&entry->hit);
 }
 //---------------------------- radio --------------------------------
 // RadioButton structure definition
@@ -566,6 +2276,8 @@ typedef struct {
     int height;
     const char *label;
     bool isSelected;
+    int offset_x, offset_y;  // Position relative to the menu, used by update_radio_position
+    rui_hit hit;             // Entry in a hit grid, see track_radio_button_group
 } RadioButton;
 
 // RadioButtonGroup structure definition
@@ -577,25 +2289,45 @@ typedef struct {
 
 // Function to create a single radio button
 RadioButton create_radio_button(int x, int y, int width, int height, const char *label) {
-    RadioButton button = { x, y, width, height, label, false };
+    RadioButton button = { x, y, width, height, label, false, x, y, { NULL, 0 } };
     return button;
 }
 
+// Area covered by the circle and the label of a radio button
+Rectangle get_radio_button_area(RadioButton *radioButton) {
+    float left = radioButton->x - radioButton->width / 2;
+    float top = radioButton->y - radioButton->height / 2;
+    float right = radioButton->x + radioButton->width + measure_text(radioButton->label, 10);
+    float bottom = top + (radioButton->height > 10 ? radioButton->height : 10);
+    return (Rectangle){ left, top, right - left, bottom - top };
+}
+
+// Clickable circle of a radio button
+static Rectangle rui_radio_hit_bounds(const RadioButton *radioButton) {
+    return (Rectangle){ radioButton->x - radioButton->width / 2, radioButton->y - radioButton->height / 2, radioButton->width, radioButton->height };
+}
+
+// Circle and label of a radio button centered on (x, y), shared by RadioButton and context radio buttons
+static void rui_draw_radio_button(int x, int y, int width, int height, const char *label, bool selected) {
+    draw_circle(x, y, width / 2, COLOR_DARKGRAY);
+    if (selected) {
+        draw_circle(x, y, width / 4, COLOR_BLUE);
+    }
+    draw_text(label, x + width, y - height / 2, 10, COLOR_BLACK);
+}
+
 // Function to render a single radio button
 void render_radio_button(RadioButton *radioButton) {
-    draw_circle(radioButton->x, radioButton->y, radioButton->width / 2, COLOR_DARKGRAY);
-    if (radioButton->isSelected) {
-        draw_circle(radioButton->x, radioButton->y, radioButton->width / 4, COLOR_BLUE);
-    }
-    draw_text(radioButton->label, radioButton->x + radioButton->width, radioButton->y - radioButton->height / 2, 10, COLOR_BLACK);
+    if (!is_damaged(get_radio_button_area(radioButton))) return;
+    rui_draw_radio_button(radioButton->x, radioButton->y, radioButton->width, radioButton->height, radioButton->label, radioButton->isSelected);
 }
 
 // Function to update the state of a single radio button
-void update_radio_button(RadioButton *radioButton) {
-    Rectangle bounds = { radioButton->x - radioButton->width / 2, radioButton->y - radioButton->height / 2, radioButton->width, radioButton->height };
-    if (CheckCollisionPointRec(GetMousePosition(), bounds) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+void update_radio_button(RadioButton *radioButton, const rui_input *input) {
+    if (rui_hit_test(&radioButton->hit, input->mouse, rui_radio_hit_bounds(radioButton)) && input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
         // Toggle selection state
         radioButton->isSelected = !radioButton->isSelected;
+        damage_rect(get_radio_button_area(radioButton));
     }
 }
 
@@ -613,20 +2345,21 @@ void render_radio_button_group(RadioButtonGroup *group) {
 }
 
 // Function to update a radio button group
-void update_radio_button_group(RadioButtonGroup *group) {
+void update_radio_button_group(RadioButtonGroup *group, const rui_input *input) {
+    if (!input->mouse_pressed[MOUSE_LEFT_BUTTON]) return;
     for (int i = 0; i < group->count; i++) {
-        Rectangle bounds = { group->buttons[i].x - group->buttons[i].width / 2, 
-                             group->buttons[i].y - group->buttons[i].height / 2, 
-                             group->buttons[i].width, 
-                             group->buttons[i].height };
-        if (CheckCollisionPointRec(GetMousePosition(), bounds) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        if (rui_hit_test(&group->buttons[i].hit, input->mouse, rui_radio_hit_bounds(&group->buttons[i]))) {
             if (group->selectedOption == i) {
                 // Deselect if the currently selected option is clicked again
                 group->selectedOption = -1;
                 group->buttons[i].isSelected = false;
+                damage_rect(get_radio_button_area(&group->buttons[i]));
             } else {
                 group->selectedOption = i;
                 for (int j = 0; j < group->count; j++) {
+                    if (group->buttons[j].isSelected != (j == i)) {
+                        damage_rect(get_radio_button_area(&group->buttons[j]));
+                    }
                     group->buttons[j].isSelected = (j == i);
                 }
             }
@@ -640,16 +2373,1689 @@ int get_selected_option(RadioButtonGroup *group) {
 }
 
 void update_radio_position(RadioButton *radioButton, MenuWindow *menu) {
+    Rectangle old_area = get_radio_button_area(radioButton);
     // Adjust button position relative to the menu
-    entry->textentry_bounds.x = menu->bounds.x + entry->x;
-    entry->textentry_bounds.y = menu->bounds.y + entry->y;
+    radioButton->x = menu->bounds.x + radioButton->offset_x;
+    radioButton->y = menu->bounds.y + radioButton->offset_y;
+    rui_damage_child_move(menu, old_area, get_radio_button_area(radioButton));
+    rui_hit_move(&radioButton->hit, rui_radio_hit_bounds(radioButton));
 }
-//--------------------------- General UI Functions ---------------------------
 
-void init_ui(char *title, int w, int h) {
-    init(title, w, h);
+// Hit test the buttons of a group through a grid, see track_button
+void track_radio_button_group(rui_hit_grid *grid, RadioButtonGroup *group, int z) {
+    for (int i = 0; i < group->count; i++) {
+        group->buttons[i].hit = rui_hit_track(grid, rui_radio_hit_bounds(&group->buttons[i]), z);
+    }
+}
+
+void untrack_radio_button_group(RadioButtonGroup *group) {
+    for (int i = 0; i < group->count; i++) rui_hit_untrack(&group->buttons[i].hit);
+}
+//--------------------------- Window Layout ---------------------------
+// A MenuWindow can own its widgets as a tree of layout containers. Each
+// widget added with add_child_* gets a rectangle relative to the window's
+// top-left corner, and update_menu_window_children/render_menu_window_children
+// run the widgets with the input and the drawing translated by the window's
+// position. Moving a window therefore touches none of its children. The tree
+// is only laid out again when the window is resized, a child is added, or a
+// size hint changes.
+//
+// Children keep their coordinates relative to the window, so they must not
+// also be positioned with update_button_position and the like, nor tracked
+// in a hit grid. Text children added to a context's focus chain with
+// add_focus_child are left to update_focus instead of being updated here.
+
+typedef enum {
+    RUI_CHILD_LAYOUT,
+    RUI_CHILD_BUTTON,
+    RUI_CHILD_TEXT_BOX,
+    RUI_CHILD_TEXT_ENTRY,
+    RUI_CHILD_RADIO_BUTTON
+} rui_child_type;
+
+#define MENU_WINDOW_ROOT 0  // Node of the window itself, the parent of its top-level children
+
+struct rui_layout_node {
+    rui_child_type type;
+    void *widget;           // NULL for containers
+    rui_layout layout;      // Containers
+    int parent;             // -1 for the window
+    int first_child;        // -1 when none
+    int last_child;
+    int next_sibling;
+    Vector2 position;       // Under RUI_LAYOUT_NONE, relative to the parent's padding
+    Vector2 size;           // Size hint; 0 on an axis measures a container's children, or fills the cross axis of a stack
+    float grow;             // Share of a flex container's free space
+    Vector2 natural;        // Measured size
+    Rectangle rect;         // Relative to the window's top-left corner
+    bool focus_chained;     // Text widget updated by update_focus, see add_focus_child
+};
+
+static void rui_window_root(MenuWindow *window) {
+    if (window->child_count > 0) return;
+    window->child_capacity = 8;
+    window->children = malloc(window->child_capacity * sizeof(rui_layout_node));
+    window->children[0] = (rui_layout_node){ .type = RUI_CHILD_LAYOUT, .parent = -1, .first_child = -1, .last_child = -1, .next_sibling = -1 };
+    window->child_count = 1;
+    window->layout_dirty = true;
+}
+
+// Place the children of the window itself; by default they keep their position
+void set_menu_window_layout(MenuWindow *window, rui_layout layout) {
+    rui_window_root(window);
+    window->children[MENU_WINDOW_ROOT].layout = layout;
+    window->layout_dirty = true;
+}
+
+static int rui_add_child(MenuWindow *window, int parent, rui_child_type type, void *widget, Rectangle initial) {
+    rui_window_root(window);
+    if (window->child_count == window->child_capacity) {
+        window->child_capacity *= 2;
+        window->children = realloc(window->children, window->child_capacity * sizeof(rui_layout_node));
+    }
+    int index = window->child_count++;
+    rui_layout_node *node = &window->children[index];
+    *node = (rui_layout_node){ .type = type, .widget = widget, .parent = parent, .first_child = -1, .last_child = -1, .next_sibling = -1 };
+    node->position = (Vector2){ initial.x, initial.y };
+    node->size = (Vector2){ initial.width, initial.height };
+
+    rui_layout_node *up = &window->children[parent];
+    if (up->last_child >= 0) window->children[up->last_child].next_sibling = index;
+    else up->first_child = index;
+    up->last_child = index;
+    window->layout_dirty = true;
+    return index;
+}
+
+// Add a container under `parent` (MENU_WINDOW_ROOT or another container); returns its node
+int add_child_layout(MenuWindow *window, int parent, rui_layout layout) {
+    int index = rui_add_child(window, parent, RUI_CHILD_LAYOUT, NULL, (Rectangle){0});
+    window->children[index].layout = layout;
+    return index;
+}
+
+// Add a widget under `parent`. Its size is the size hint, and its
+// create_* position is kept when the parent does not lay out its children.
+int add_child_button(MenuWindow *window, int parent, Button *button) {
+    return rui_add_child(window, parent, RUI_CHILD_BUTTON, button, (Rectangle){ button->x, button->y, button->width, button->height });
+}
+
+int add_child_text_box(MenuWindow *window, int parent, TextBox *text_box) {
+    rui_rect bounds = text_box->textbox_bounds;
+    return rui_add_child(window, parent, RUI_CHILD_TEXT_BOX, text_box, (Rectangle){ text_box->x, text_box->y, bounds.width, bounds.height });
+}
+
+int add_child_text_entry(MenuWindow *window, int parent, TextEntry *entry) {
+    rui_rect bounds = entry->textentry_bounds;
+    return rui_add_child(window, parent, RUI_CHILD_TEXT_ENTRY, entry, (Rectangle){ entry->x, entry->y, bounds.width, bounds.height });
+}
+
+int add_child_radio_button(MenuWindow *window, int parent, RadioButton *radioButton) {
+    Rectangle area = get_radio_button_area(radioButton);
+    area.x -= radioButton->x - radioButton->offset_x;
+    area.y -= radioButton->y - radioButton->offset_y;
+    return rui_add_child(window, parent, RUI_CHILD_RADIO_BUTTON, radioButton, area);
+}
+
+// Change the size hint and flex share of a child; the window is laid out again only if they changed
+void set_child_size(MenuWindow *window, int child, float width, float height, float grow) {
+    rui_layout_node *node = &window->children[child];
+    if (node->size.x == width && node->size.y == height && node->grow == grow) return;
+    node->size = (Vector2){ width, height };
+    node->grow = grow;
+    window->layout_dirty = true;
+}
+
+// Screen rectangle of a child, as of the last layout
+Rectangle get_child_rect(const MenuWindow *window, int child) {
+    Rectangle rect = window->children[child].rect;
+    return (Rectangle){ window->bounds.x + rect.x, window->bounds.y + rect.y, rect.width, rect.height };
+}
+
+static Vector2 rui_layout_measure(MenuWindow *window, int index) {
+    rui_layout_node *node = &window->children[index];
+    Vector2 natural = node->size;
+    if (node->type == RUI_CHILD_LAYOUT) {
+        const rui_layout *layout = &node->layout;
+        bool horizontal = layout->horizontal;
+        int columns = layout->columns > 0 ? layout->columns : 1;
+        float width = 0, height = 0, cell_width = 0, row_height = 0;
+        int count = 0;
+        for (int c = node->first_child; c >= 0; c = window->children[c].next_sibling) {
+            Vector2 size = rui_layout_measure(window, c);
+            const rui_layout_node *child = &window->children[c];
+            switch (layout->kind) {
+            case RUI_LAYOUT_NONE:
+                if (child->position.x + size.x > width) width = child->position.x + size.x;
+                if (child->position.y + size.y > height) height = child->position.y + size.y;
+                break;
+            case RUI_LAYOUT_STACK:
+            case RUI_LAYOUT_FLEX:
+                if (horizontal) {
+                    width += size.x + (count > 0 ? layout->spacing : 0);
+                    if (size.y > height) height = size.y;
+                } else {
+                    height += size.y + (count > 0 ? layout->spacing : 0);
+                    if (size.x > width) width = size.x;
+                }
+                break;
+            case RUI_LAYOUT_GRID:
+                if (size.x > cell_width) cell_width = size.x;
+                if (count % columns == 0) {
+                    height += row_height + (count > 0 ? layout->spacing : 0);
+                    row_height = 0;
+                }
+                if (size.y > row_height) row_height = size.y;
+                break;
+            }
+            count++;
+        }
+        if (layout->kind == RUI_LAYOUT_GRID) {
+            height += row_height;
+            int used = count < columns ? count : columns;
+            width = used * cell_width + (used > 1 ? (used - 1) * layout->spacing : 0);
+        }
+        if (natural.x <= 0) natural.x = width + 2 * layout->padding;
+        if (natural.y <= 0) natural.y = height + 2 * layout->padding;
+    }
+    node->natural = natural;
+    return natural;
+}
+
+// Move a widget to its laid out rectangle
+static void rui_layout_place(rui_layout_node *node, Rectangle rect) {
+    switch (node->type) {
+    case RUI_CHILD_BUTTON: {
+        Button *button = node->widget;
+        button->x = rect.x;
+        button->y = rect.y;
+        button->width = rect.width;
+        button->height = rect.height;
+        button->button_bounds = (rui_rect){ rect.x, rect.y, rect.width, rect.height };
+        break;
+    }
+    case RUI_CHILD_TEXT_BOX: {
+        TextBox *text_box = node->widget;
+        text_box->x = rect.x;
+        text_box->y = rect.y;
+        text_box->textbox_bounds = (rui_rect){ rect.x, rect.y, rect.width, rect.height };
+        break;
+    }
+    case RUI_CHILD_TEXT_ENTRY: {
+        TextEntry *entry = node->widget;
+        entry->x = rect.x;
+        entry->y = rect.y;
+        entry->textentry_bounds = (rui_rect){ rect.x, rect.y, rect.width, rect.height };
+        rui_entry_scroll(entry);
+        break;
+    }
+    case RUI_CHILD_RADIO_BUTTON: {
+        RadioButton *radioButton = node->widget;
+        radioButton->x = radioButton->offset_x = rect.x + radioButton->width / 2;
+        radioButton->y = radioButton->offset_y = rect.y + radioButton->height / 2;
+        break;
+    }
+    case RUI_CHILD_LAYOUT:
+        break;
+    }
+}
+
+static void rui_layout_arrange(MenuWindow *window, int index, Rectangle rect) {
+    rui_layout_node *node = &window->children[index];
+    node->rect = rect;
+    if (node->type != RUI_CHILD_LAYOUT) {
+        rui_layout_place(node, rect);
+        return;
+    }
+    const rui_layout *layout = &node->layout;
+    float padding = layout->padding, spacing = layout->spacing;
+    Rectangle inner = { rect.x + padding, rect.y + padding, rect.width - 2 * padding, rect.height - 2 * padding };
+    rui_layout_node *children = window->children;
+
+    switch (layout->kind) {
+    case RUI_LAYOUT_NONE:
+        for (int c = node->first_child; c >= 0; c = children[c].next_sibling) {
+            Vector2 size = children[c].natural;
+            rui_layout_arrange(window, c, (Rectangle){ inner.x + children[c].position.x, inner.y + children[c].position.y, size.x, size.y });
+        }
+        break;
+    case RUI_LAYOUT_STACK:
+    case RUI_LAYOUT_FLEX: {
+        bool horizontal = layout->horizontal;
+        float free = horizontal ? inner.width : inner.height;
+        float total_grow = 0;
+        int count = 0;
+        for (int c = node->first_child; c >= 0; c = children[c].next_sibling) {
+            free -= (horizontal ? children[c].natural.x : children[c].natural.y) + (count++ > 0 ? spacing : 0);
+            total_grow += children[c].grow;
+        }
+        float position = horizontal ? inner.x : inner.y;
+        for (int c = node->first_child; c >= 0; c = children[c].next_sibling) {
+            const rui_layout_node *child = &children[c];
+            float main = horizontal ? child->natural.x : child->natural.y;
+            if (layout->kind == RUI_LAYOUT_FLEX && free > 0 && child->grow > 0) main += free * child->grow / total_grow;
+            // The cross axis is filled unless the child asked for a size
+            float cross_hint = horizontal ? child->size.y : child->size.x;
+            float cross = horizontal ? inner.height : inner.width;
+            if (cross_hint > 0) cross = cross_hint;
+            Rectangle cell = horizontal ? (Rectangle){ position, inner.y, main, cross } : (Rectangle){ inner.x, position, cross, main };
+            rui_layout_arrange(window, c, cell);
+            position += main + spacing;
+        }
+        break;
+    }
+    case RUI_LAYOUT_GRID: {
+        int columns = layout->columns > 0 ? layout->columns : 1;
+        float cell_width = (inner.width - (columns - 1) * spacing) / columns;
+        float y = inner.y;
+        int c = node->first_child;
+        while (c >= 0) {
+            float row_height = 0;
+            int end = c;
+            for (int k = 0; k < columns && end >= 0; k++, end = children[end].next_sibling) {
+                if (children[end].natural.y > row_height) row_height = children[end].natural.y;
+            }
+            for (int k = 0; c != end; k++, c = children[c].next_sibling) {
+                rui_layout_arrange(window, c, (Rectangle){ inner.x + k * (cell_width + spacing), y, cell_width, row_height });
+            }
+            y += row_height + spacing;
+        }
+        break;
+    }
+    }
+}
+
+// Lay the children out again if the window was resized or the tree changed
+static void rui_layout_window(MenuWindow *window) {
+    if (window->child_count == 0) return;
+    if (!window->layout_dirty && window->laid_out_size.x == window->bounds.width && window->laid_out_size.y == window->bounds.height) return;
+    rui_layout_measure(window, MENU_WINDOW_ROOT);
+    // Positioned children are relative to the window's corner, laid out ones fill the area below the title
+    Rectangle content = { 0, 0, window->bounds.width, window->bounds.height };
+    if (window->children[MENU_WINDOW_ROOT].layout.kind != RUI_LAYOUT_NONE && window->showTitle) {
+        content.y = 30;
+        content.height -= 30;
+    }
+    rui_layout_arrange(window, MENU_WINDOW_ROOT, content);
+    window->layout_dirty = false;
+    window->laid_out_size = (Vector2){ window->bounds.width, window->bounds.height };
+    damage_rect(window->bounds);
+}
+
+// A text child of a focus chain is only updated by update_focus. The window
+// notes a press on it, which it only sees when no window above covers the
+// child, so that update_focus gives it the keyboard.
+static void rui_note_focus_press(MenuWindow *window, const rui_layout_node *node, const rui_input *local) {
+    if (local->mouse_pressed[MOUSE_LEFT_BUTTON] && CheckCollisionPointRec(local->mouse, node->rect)) window->focus_pressed = node->widget;
+}
+
+// Update the window's children; call after update_menu_window. Returns the
+// node of the button clicked this frame, or -1.
+int update_menu_window_children(MenuWindow *window, const rui_input *input) {
+    window->focus_pressed = NULL;
+    if (window->child_count == 0) return -1;
+    rui_layout_window(window);
+    rui_input local = *input;
+    local.mouse.x -= window->bounds.x;
+    local.mouse.y -= window->bounds.y;
+    int clicked = -1;
+    begin_translate(window->bounds.x, window->bounds.y);
+    for (int i = 1; i < window->child_count; i++) {
+        rui_layout_node *node = &window->children[i];
+        switch (node->type) {
+        case RUI_CHILD_BUTTON:
+            if (update_button(node->widget, &local)) clicked = i;
+            break;
+        case RUI_CHILD_TEXT_BOX:
+            if (node->focus_chained) rui_note_focus_press(window, node, &local);
+            else update_text_box(node->widget, &local);
+            break;
+        case RUI_CHILD_TEXT_ENTRY:
+            if (node->focus_chained) rui_note_focus_press(window, node, &local);
+            else update_text_entry(node->widget, &local);
+            break;
+        case RUI_CHILD_RADIO_BUTTON:
+            update_radio_button(node->widget, &local);
+            break;
+        case RUI_CHILD_LAYOUT:
+            break;
+        }
+    }
+    end_translate();
+    return clicked;
+}
+
+// Draw the window's children, between begin_menu_window and end_menu_window
+void render_menu_window_children(MenuWindow *window) {
+    begin_translate(window->bounds.x, window->bounds.y);
+    for (int i = 1; i < window->child_count; i++) {
+        rui_layout_node *node = &window->children[i];
+        switch (node->type) {
+        case RUI_CHILD_BUTTON:
+            render_button(node->widget);
+            break;
+        case RUI_CHILD_TEXT_BOX:
+            render_text_box(node->widget);
+            break;
+        case RUI_CHILD_TEXT_ENTRY:
+            render_text_entry(node->widget);
+            break;
+        case RUI_CHILD_RADIO_BUTTON:
+            render_radio_button(node->widget);
+            break;
+        case RUI_CHILD_LAYOUT:
+            break;
+        }
+    }
+    end_translate();
+}
+
+// Free the child list and the cached surface of a window. The widgets belong to the application.
+void destroy_menu_window(MenuWindow *window) {
+    set_menu_window_cached(window, false);
+    free(window->children);
+    window->children = NULL;
+    window->child_count = window->child_capacity = 0;
+}
+
+//--------------------------- Window Manager ---------------------------
+// Keeps overlapping MenuWindows in z-order. The pointer goes only to the
+// top-most window under it, or to the window it was pressed on until it is
+// released, so a click on a stack of windows drags one of them. Pressing a
+// window brings it to the front, and the keyboard goes to the front window.
+// The other windows are updated with the pointer far away, so their hover
+// states clear, and without key presses.
+//
+// Windows paint their whole bounds, so each hides what is below it. A window
+// entirely covered by windows above it is not rendered at all, and the part
+// of a window cut off by a window covering one of its sides is clipped away,
+// so its rows and children there are neither drawn nor recorded.
+
+#define RUI_MAX_WINDOWS 64
+
+typedef struct {
+    MenuWindow *windows[RUI_MAX_WINDOWS];  // Back to front
+    int clicked[RUI_MAX_WINDOWS];          // Child node clicked in each window this frame, or -1
+    int count;
+    MenuWindow *captured;                  // Window the pointer was pressed on, until it is released
+    MenuWindow *hovered;                   // Window the pointer went to this frame, or NULL
+    int occluded;                          // Windows skipped by the last render for being covered
+} rui_window_manager;
+
+rui_window_manager create_window_manager() {
+    rui_window_manager manager = {0};
+    return manager;
+}
+
+static int rui_window_index(const rui_window_manager *manager, const MenuWindow *window) {
+    for (int i = 0; i < manager->count; i++) {
+        if (manager->windows[i] == window) return i;
+    }
+    return -1;
+}
+
+// Add a window on top of the others; returns false when RUI_MAX_WINDOWS are managed
+bool add_managed_window(rui_window_manager *manager, MenuWindow *window) {
+    if (rui_window_index(manager, window) >= 0) return true;
+    if (manager->count == RUI_MAX_WINDOWS) {
+        TraceLog(LOG_WARNING, "RUI: window manager full, window not added");
+        return false;
+    }
+    manager->clicked[manager->count] = -1;
+    manager->windows[manager->count++] = window;
+    damage_rect(window->bounds);
+    return true;
+}
+
+// Stop managing a window; what was below it is redrawn
+void remove_managed_window(rui_window_manager *manager, MenuWindow *window) {
+    int index = rui_window_index(manager, window);
+    if (index < 0) return;
+    for (int i = index; i < manager->count - 1; i++) {
+        manager->windows[i] = manager->windows[i + 1];
+        manager->clicked[i] = manager->clicked[i + 1];
+    }
+    manager->count--;
+    if (manager->captured == window) manager->captured = NULL;
+    if (manager->hovered == window) manager->hovered = NULL;
+    damage_rect(window->bounds);
+}
+
+void bring_window_to_front(rui_window_manager *manager, MenuWindow *window) {
+    int index = rui_window_index(manager, window);
+    if (index < 0 || index == manager->count - 1) return;
+    int clicked = manager->clicked[index];
+    for (int i = index; i < manager->count - 1; i++) {
+        manager->windows[i] = manager->windows[i + 1];
+        manager->clicked[i] = manager->clicked[i + 1];
+    }
+    manager->windows[manager->count - 1] = window;
+    manager->clicked[manager->count - 1] = clicked;
+    // Nothing inside the windows changed, only which one shows where they overlap
+    recomposite_rect(window->bounds);
+}
+
+// Top-most window under a screen point, or NULL
+MenuWindow *window_at(const rui_window_manager *manager, Vector2 point) {
+    for (int i = manager->count - 1; i >= 0; i--) {
+        if (CheckCollisionPointRec(point, manager->windows[i]->bounds)) return manager->windows[i];
+    }
+    return NULL;
+}
+
+// Update every window and its children with the input routed to it
+void update_window_manager(rui_window_manager *manager, const rui_input *input) {
+    bool held = false, pressed = false;
+    for (int b = 0; b < 3; b++) {
+        held |= input->mouse_down[b] || input->mouse_released[b];
+        pressed |= input->mouse_pressed[b];
+    }
+    if (!held) manager->captured = NULL;
+    MenuWindow *target = manager->captured ? manager->captured : window_at(manager, input->mouse);
+    if (pressed && target) {
+        bring_window_to_front(manager, target);
+        manager->captured = target;
+    }
+    manager->hovered = target;
+
+    rui_input elsewhere = *input;
+    elsewhere.mouse = (Vector2){ -1e9f, -1e9f };
+    for (int b = 0; b < 3; b++) elsewhere.mouse_pressed[b] = elsewhere.mouse_released[b] = false;
+    elsewhere.wheel = 0;
+
+    for (int i = 0; i < manager->count; i++) {
+        MenuWindow *window = manager->windows[i];
+        rui_input routed = window == target ? *input : elsewhere;
+        if (i != manager->count - 1) routed.key_count = routed.char_count = routed.event_count = 0;
+        update_menu_window(window, &routed);
+        manager->clicked[i] = update_menu_window_children(window, &routed);
+    }
+}
+
+// Child node of `window` clicked during the last update, or -1
+int managed_window_clicked(const rui_window_manager *manager, const MenuWindow *window) {
+    int index = rui_window_index(manager, window);
+    return index < 0 ? -1 : manager->clicked[index];
+}
+
+// What is left of `visible` once `cover` is drawn over it, when that is still
+// a rectangle, i.e. when `cover` spans a whole side of it; `visible` otherwise
+static Rectangle rui_rect_uncovered(Rectangle visible, Rectangle cover) {
+    float left = visible.x, top = visible.y;
+    float right = visible.x + visible.width, bottom = visible.y + visible.height;
+    float cover_right = cover.x + cover.width, cover_bottom = cover.y + cover.height;
+    if (cover.x <= left && cover_right >= right) {
+        if (cover.y <= top && cover_bottom > top) top = cover_bottom;
+        else if (cover.y < bottom && cover_bottom >= bottom) bottom = cover.y;
+    } else if (cover.y <= top && cover_bottom >= bottom) {
+        if (cover.x <= left && cover_right > left) left = cover_right;
+        else if (cover.x < right && cover_right >= right) right = cover.x;
+    }
+    return (Rectangle){ left, top, right - left, bottom - top };
+}
+
+// Render the windows back to front, leaving out what other windows hide
+void render_window_manager(rui_window_manager *manager) {
+    manager->occluded = 0;
+    for (int i = 0; i < manager->count; i++) {
+        MenuWindow *window = manager->windows[i];
+        Rectangle visible = window->bounds;
+        for (int j = i + 1; j < manager->count && visible.width > 0 && visible.height > 0; j++) {
+            visible = rui_rect_uncovered(visible, manager->windows[j]->bounds);
+        }
+        if (visible.width <= 0 || visible.height <= 0) {
+            manager->occluded++;
+            continue;
+        }
+        bool clipped = memcmp(&visible, &window->bounds, sizeof(Rectangle)) != 0;
+        if (clipped) {
+            int left = (int)visible.x, top = (int)visible.y;
+            begin_scissor(left, top, (int)(visible.x + visible.width + 0.999f) - left, (int)(visible.y + visible.height + 0.999f) - top);
+        }
+        if (begin_menu_window(window)) render_menu_window_children(window);
+        end_menu_window(window);
+        if (clipped) end_scissor();
+    }
+}
+
+//--------------------------- Widget Pools ---------------------------
+// Fixed-capacity storage for widgets that come and go, e.g. the rows of a
+// table or short-lived dialogs. A pool holds one widget type; all its memory
+// is allocated by create_pool, so creating and destroying widgets afterwards
+// is O(1) and allocates nothing. Items start on a cache line and are padded
+// so that none straddles more lines than its size requires.
+//
+// Widgets are referred to by handles. A handle carries the generation of its
+// slot, which changes whenever the slot is freed, so pool_get returns NULL for
+// a handle to a destroyed widget instead of whatever reused the slot.
+//
+// Text boxes and entries keep their text buffers in the slot when they are
+// destroyed, emptied, and the next widget created there grows them instead of
+// allocating its own. Such pools are released with destroy_text_box_pool or
+// destroy_text_entry_pool, which free those buffers too.
+
+#define RUI_CACHE_LINE 64
+
+typedef struct {
+    uint32_t index;
+    uint32_t generation;    // odd while the slot is in use; 0 is never valid, so a zeroed handle is null
+} rui_handle;
+
+typedef struct {
+    uint8_t *items;
+    uint32_t *generations;
+    int *free_slots;        // stack of unused slots
+    int free_count;
+    int item_size;          // sizeof the widget type the pool was created for
+    int stride;             // bytes from one item to the next
+    int capacity;
+} rui_pool;
+
+// Room for `capacity` items of `item_size` bytes, e.g. sizeof(Button)
+rui_pool create_pool(int item_size, int capacity) {
+    rui_pool pool = {0};
+    // Small items get a power-of-two stride that divides a cache line, larger ones whole lines
+    pool.stride = 1;
+    while (pool.stride < item_size && pool.stride < RUI_CACHE_LINE) pool.stride *= 2;
+    if (item_size > RUI_CACHE_LINE) pool.stride = (item_size + RUI_CACHE_LINE - 1) / RUI_CACHE_LINE * RUI_CACHE_LINE;
+    size_t bytes = (size_t)pool.stride * capacity;
+    pool.items = aligned_alloc(RUI_CACHE_LINE, (bytes + RUI_CACHE_LINE - 1) / RUI_CACHE_LINE * RUI_CACHE_LINE);
+    pool.generations = calloc(capacity, sizeof(uint32_t));
+    pool.free_slots = malloc(capacity * sizeof(int));
+    if (!pool.items || !pool.generations || !pool.free_slots) {
+        TraceLog(LOG_WARNING, "RUI: could not allocate a pool of %d items", capacity);
+        free(pool.items);
+        free(pool.generations);
+        free(pool.free_slots);
+        return (rui_pool){0};
+    }
+    // Zeroed, so a slot never used yet holds no text buffers
+    memset(pool.items, 0, bytes);
+    pool.item_size = item_size;
+    pool.capacity = capacity;
+    // Hand out the lowest slots first
+    for (int i = 0; i < capacity; i++) pool.free_slots[i] = capacity - 1 - i;
+    pool.free_count = capacity;
+    return pool;
+}
+
+void destroy_pool(rui_pool *pool) {
+    free(pool->items);
+    free(pool->generations);
+    free(pool->free_slots);
+    *pool = (rui_pool){0};
+}
+
+// Take a free slot; returns a null handle and sets *item to NULL when the pool is full
+rui_handle pool_alloc(rui_pool *pool, void **item) {
+    if (pool->free_count == 0) {
+        *item = NULL;
+        return (rui_handle){0};
+    }
+    int index = pool->free_slots[--pool->free_count];
+    pool->generations[index]++;
+    *item = pool->items + (size_t)index * pool->stride;
+    return (rui_handle){ index, pool->generations[index] };
+}
+
+// Item of a live handle, or NULL if it is null or its widget was destroyed
+void *pool_get(const rui_pool *pool, rui_handle handle) {
+    if (handle.index >= (uint32_t)pool->capacity || pool->generations[handle.index] != handle.generation) return NULL;
+    if (!(handle.generation & 1)) return NULL;
+    return pool->items + (size_t)handle.index * pool->stride;
+}
+
+// Release a slot; returns false for a stale handle, which is left alone
+bool pool_free(rui_pool *pool, rui_handle handle) {
+    if (!pool_get(pool, handle)) return false;
+    pool->generations[handle.index]++;
+    pool->free_slots[pool->free_count++] = handle.index;
+    return true;
+}
+
+// Item in slot `index`, or NULL when the slot is free; walks all items of a pool
+void *pool_item(const rui_pool *pool, int index) {
+    if (!(pool->generations[index] & 1)) return NULL;
+    return pool->items + (size_t)index * pool->stride;
+}
+
+int pool_count(const rui_pool *pool) {
+    return pool->capacity - pool->free_count;
+}
+
+// Pooled versions of the create_* functions; they return a null handle when
+// the pool is full or was created for another widget type. Text entries are
+// initialized in place.
+
+static bool rui_pool_holds(const rui_pool *pool, size_t item_size, const char *type) {
+    if ((size_t)pool->item_size == item_size) return true;
+    TraceLog(LOG_WARNING, "RUI: pool of %d-byte items used for %s (%d bytes)", pool->item_size, type, (int)item_size);
+    return false;
+}
+
+rui_handle pool_create_button(rui_pool *pool, char *text, float x, float y) {
+    if (!rui_pool_holds(pool, sizeof(Button), "Button")) return (rui_handle){0};
+    Button *button;
+    rui_handle handle = pool_alloc(pool, (void **)&button);
+    if (button) *button = create_button(text, x, y);
+    return handle;
+}
+
+rui_handle pool_create_text_entry(rui_pool *pool, float x, float y, float width, float height, int font_size, RUI_COLOR text_color, RUI_COLOR background_color) {
+    if (!rui_pool_holds(pool, sizeof(TextEntry), "TextEntry")) return (rui_handle){0};
+    TextEntry *entry;
+    rui_handle handle = pool_alloc(pool, (void **)&entry);
+    if (!entry) return handle;
+    // Take over the buffers the last entry in this slot left behind
+    char *text = entry->text;
+    float *text_x = entry->text_x;
+    int capacity = entry->capacity;
+    init_text_entry(entry, x, y, width, height, font_size, text_color, background_color);
+    if (capacity > 0) {
+        entry->text = text;
+        entry->text_x = text_x;
+        entry->capacity = capacity;
+        entry->text[0] = '\0';
+        entry->text_x[0] = 0;
+    }
+    return handle;
+}
+
+rui_handle pool_create_text_box(rui_pool *pool, float x, float y, float width, float height, int font_size, RUI_COLOR text_color, RUI_COLOR background_color, const char *placeholder) {
+    if (!rui_pool_holds(pool, sizeof(TextBox), "TextBox")) return (rui_handle){0};
+    TextBox *text_box;
+    rui_handle handle = pool_alloc(pool, (void **)&text_box);
+    if (!text_box) return handle;
+    // Take over the buffers the last text box in this slot left behind, emptied
+    rui_text_buffer text = text_box->text;
+    rui_wrap_index wrap = text_box->wrap;
+    *text_box = create_text_box(x, y, width, height, font_size, text_color, background_color, placeholder);
+    text_box->text = (rui_text_buffer){
+        .data = text.data, .capacity = text.capacity, .gap_start = 0, .gap_end = text.capacity,
+        .lines = text.lines, .line_capacity = text.line_capacity, .line_gap_start = 0, .line_gap_end = text.line_capacity,
+    };
+    text_box->wrap = (rui_wrap_index){ .rows = wrap.rows, .capacity = wrap.capacity, .gap_start = 0, .gap_end = wrap.capacity };
+    return handle;
+}
+
+// Release a pooled button's hit grid entry along with its slot
+bool pool_destroy_button(rui_pool *pool, rui_handle handle) {
+    Button *button = pool_get(pool, handle);
+    if (!button) return false;
+    untrack_button(button);
+    return pool_free(pool, handle);
+}
+
+// Release a pooled text entry's hit grid entry along with its slot; its text buffers stay for the next entry
+bool pool_destroy_text_entry(rui_pool *pool, rui_handle handle) {
+    TextEntry *entry = pool_get(pool, handle);
+    if (!entry) return false;
+    untrack_text_entry(entry);
+    return pool_free(pool, handle);
+}
+
+// Release a pooled text box's hit grid entry along with its slot; its text buffers stay for the next text box
+bool pool_destroy_text_box(rui_pool *pool, rui_handle handle) {
+    TextBox *text_box = pool_get(pool, handle);
+    if (!text_box) return false;
+    untrack_text_box(text_box);
+    return pool_free(pool, handle);
+}
+
+// Free the text of every slot, used or not, then the pool
+void destroy_text_entry_pool(rui_pool *pool) {
+    if (pool->item_size == (int)sizeof(TextEntry)) {
+        for (int i = 0; i < pool->capacity; i++) destroy_text_entry((TextEntry *)(pool->items + (size_t)i * pool->stride));
+    }
+    destroy_pool(pool);
+}
+
+void destroy_text_box_pool(rui_pool *pool) {
+    if (pool->item_size == (int)sizeof(TextBox)) {
+        for (int i = 0; i < pool->capacity; i++) destroy_text_box((TextBox *)(pool->items + (size_t)i * pool->stride));
+    }
+    destroy_pool(pool);
+}
+
+rui_handle pool_create_menu_window(
+    rui_pool *pool, int x, int y, int width, int height, const char* title, WindowMode mode,
+    bool showTitle, bool movable, bool scrollEnabled, float contentHeight
+) {
+    if (!rui_pool_holds(pool, sizeof(MenuWindow), "MenuWindow")) return (rui_handle){0};
+    MenuWindow *window;
+    rui_handle handle = pool_alloc(pool, (void **)&window);
+    if (window) *window = create_menu_window(x, y, width, height, title, mode, showTitle, movable, scrollEnabled, contentHeight);
+    return handle;
+}
+
+// Release the surface and children of a pooled window along with its slot
+bool pool_destroy_menu_window(rui_pool *pool, rui_handle handle) {
+    MenuWindow *window = pool_get(pool, handle);
+    if (!window) return false;
+    destroy_menu_window(window);
+    return pool_free(pool, handle);
+}
+
+//--------------------------- Frame Arena ---------------------------
+// Bump allocator for memory that only lives for one frame: formatted labels,
+// layout scratch arrays, wrapped line lists. A rui_context owns one and
+// rui_begin resets it, so what arena_alloc returns is valid until the next
+// rui_begin and must not be kept longer. Allocations that do not fit get
+// their own malloc for the rest of the frame, and the reset grows the block to
+// hold everything, so after the first frames a steady UI allocates nothing.
+//
+// With RUI_DEBUG_ARENA defined, every new high-water mark is logged and the
+// block is filled with 0xCD on reset, so a string kept past its frame shows
+// up as garbage instead of silently aliasing the next frame's strings.
+
+#define RUI_ARENA_ALIGN 16
+#define RUI_ARENA_INITIAL 65536
+
+typedef struct {
+    uint8_t *base;
+    size_t capacity;
+    size_t used;
+    void **overflow;            // allocations that did not fit this frame
+    int overflow_count;
+    int overflow_capacity;
+    size_t overflow_bytes;
+    size_t high_water;          // most bytes used in one frame
+} rui_arena;
+
+// Memory for this frame, aligned for any type; NULL only if the heap is exhausted
+void *arena_alloc(rui_arena *arena, size_t size) {
+    size_t offset = (arena->used + RUI_ARENA_ALIGN - 1) & ~(size_t)(RUI_ARENA_ALIGN - 1);
+    if (!arena->base && size <= RUI_ARENA_INITIAL) {
+        arena->base = malloc(RUI_ARENA_INITIAL);
+        arena->capacity = arena->base ? RUI_ARENA_INITIAL : 0;
+    }
+    if (offset + size <= arena->capacity) {
+        arena->used = offset + size;
+        return arena->base + offset;
+    }
+    if (arena->overflow_count == arena->overflow_capacity) {
+        arena->overflow_capacity = arena->overflow_capacity ? arena->overflow_capacity * 2 : 16;
+        arena->overflow = realloc(arena->overflow, arena->overflow_capacity * sizeof(void *));
+    }
+    void *memory = malloc(size);
+    if (memory) {
+        arena->overflow[arena->overflow_count++] = memory;
+        arena->overflow_bytes += size + RUI_ARENA_ALIGN;
+    }
+    return memory;
+}
+
+// printf into the arena
+char *arena_printf(rui_arena *arena, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list measure;
+    va_copy(measure, args);
+    int length = vsnprintf(NULL, 0, format, measure);
+    va_end(measure);
+    char *text = length >= 0 ? arena_alloc(arena, length + 1) : NULL;
+    if (text) vsnprintf(text, length + 1, format, args);
+    va_end(args);
+    return text;
+}
+
+// Free everything allocated since the last reset, in O(1) unless the block has to grow
+void arena_reset(rui_arena *arena) {
+    size_t total = arena->used + arena->overflow_bytes;
+    if (total > arena->high_water) {
+        arena->high_water = total;
+#ifdef RUI_DEBUG_ARENA
+        TraceLog(LOG_INFO, "RUI: frame arena high-water mark %lu bytes", (unsigned long)total);
+#endif
+    }
+    if (arena->overflow_count) {
+        for (int i = 0; i < arena->overflow_count; i++) free(arena->overflow[i]);
+        arena->overflow_count = 0;
+        arena->overflow_bytes = 0;
+        // Grow to fit such a frame with room to spare
+        free(arena->base);
+        arena->capacity = total + total / 2;
+        arena->base = malloc(arena->capacity);
+        if (!arena->base) arena->capacity = 0;
+    }
+#ifdef RUI_DEBUG_ARENA
+    if (arena->base) memset(arena->base, 0xCD, arena->used < arena->capacity ? arena->used : arena->capacity);
+#endif
+    arena->used = 0;
+}
+
+void free_arena(rui_arena *arena) {
+    arena_reset(arena);
+    free(arena->base);
+    free(arena->overflow);
+    *arena = (rui_arena){0};
+}
+
+//--------------------------- UI Context ---------------------------
+// Widgets owned by a context instead of the application, in one pool per
+// widget type. What update and render read every frame, the bounds and the
+// state flags, sits in tight parallel arrays; labels and colors sit in a cold
+// array that is only read when a widget is drawn. update_context finds the
+// widget under the pointer with one batch scan of the bounds, and
+// render_context walks the arrays in order. Widgets are referred to by their
+// index in the pool.
+
+enum {
+    RUI_WIDGET_HOVERED = 1 << 0,
+    RUI_WIDGET_PRESSED = 1 << 1,   // Mouse button held down on the widget
+    RUI_WIDGET_CLICKED = 1 << 2,   // Mouse button released on the widget this frame
+    RUI_WIDGET_SELECTED = 1 << 3
+};
+
+typedef struct {
+    const char *text;
+    int font_size;
+    RUI_COLOR color;
+    RUI_COLOR hover_color;
+    RUI_COLOR clicked_color;
+    RUI_COLOR text_color;
+} rui_button_style;
+
+typedef struct {
+    rui_rect_array bounds;      // Hot; bounds.count is the number of buttons
+    uint8_t *state;             // Hot, RUI_WIDGET_* flags
+    rui_button_style *style;    // Cold
+    int capacity;               // Of state and style
+    int hovered;                // Button under the pointer, -1 if none
+    int clicked;                // Button with RUI_WIDGET_CLICKED set, -1 if none
+} rui_button_pool;
+
+typedef struct {
+    const char *label;
+    float label_width;
+} rui_radio_style;
+
+typedef struct {
+    rui_rect_array bounds;      // Hot: the circles
+    uint8_t *state;             // Hot
+    int *group;                 // Hot: at most one radio button per group is selected
+    rui_radio_style *style;     // Cold
+    int capacity;
+} rui_radio_pool;
+
+#define RUI_ID_STACK_DEPTH 32
+#define RUI_STATE_MAX_AGE 120   // frames an immediate-mode widget may go unused before its state is dropped
+
+// A text widget in the Tab order, see "Keyboard Focus"
+typedef enum {
+    RUI_FOCUS_TEXT_BOX,
+    RUI_FOCUS_TEXT_ENTRY
+} rui_focus_kind;
+
+typedef struct {
+    rui_focus_kind kind;
+    void *widget;               // TextBox or TextEntry
+    MenuWindow *window;         // Window of a child widget, whose bounds are relative to it; NULL otherwise
+} rui_focus_entry;
+
+// What an immediate-mode widget keeps between frames, see rui_begin
+typedef struct {
+    uint32_t id;            // 0 marks an empty slot
+    uint32_t last_frame;    // last frame the widget was drawn
+    Rectangle bounds;       // as drawn, damaged when the widget moves or goes away
+    uint32_t look;          // hash of what was drawn, damaged when it changes
+    int cursor;             // text fields
+    int offset;             // text fields: first visible byte
+    float scroll;           // scroll areas
+} rui_state_entry;
+
+typedef struct {
+    rui_button_pool buttons;
+    rui_radio_pool radios;
+
+    // Keyboard focus
+    rui_focus_entry *focus_chain;   // in Tab order
+    int focus_count;
+    int focus_capacity;
+    int focused;                    // index in focus_chain, -1 if none
+
+    // Immediate mode
+    const rui_input *input;
+    uint32_t frame;
+    uint32_t id_stack[RUI_ID_STACK_DEPTH];
+    int id_depth;
+    rui_state_entry *states;    // open addressing with linear probing, capacity is a power of two
+    int state_capacity;
+    int state_count;
+    uint32_t hot;               // widget under the pointer
+    Rectangle hot_bounds;
+    uint32_t next_hot;          // top-most widget under the pointer this frame, hot in the next one
+    Rectangle next_hot_bounds;
+    uint32_t active;            // widget the left button went down on, until it is released
+    uint32_t focus;             // text field receiving keys, unless a widget of the focus chain has them
+    float drag_offset;          // pointer to slider knob distance while dragging
+    Rectangle clip;             // visible part of the scroll areas being drawn, if clip_depth > 0
+    Rectangle clips[RUI_ID_STACK_DEPTH];  // enclosing clips
+    int clip_depth;
+
+    rui_arena arena;            // per-frame memory, reset by rui_begin
+} rui_context;
+
+rui_context create_context(void) {
+    rui_context ctx = {0};
+    ctx.buttons.hovered = -1;
+    ctx.buttons.clicked = -1;
+    ctx.focused = -1;
+    return ctx;
+}
+
+void destroy_context(rui_context *ctx) {
+    free_rect_array(&ctx->buttons.bounds);
+    free(ctx->buttons.state);
+    free(ctx->buttons.style);
+    free_rect_array(&ctx->radios.bounds);
+    free(ctx->radios.state);
+    free(ctx->radios.group);
+    free(ctx->radios.style);
+    free(ctx->focus_chain);
+    free(ctx->states);
+    free_arena(&ctx->arena);
+    *ctx = create_context();
+}
+
+// Add a button with the size and colors of create_button; returns its index
+int add_button(rui_context *ctx, const char *text, float x, float y) {
+    rui_button_pool *pool = &ctx->buttons;
+    int i = rect_array_add(&pool->bounds, (Rectangle){ x, y, 70, 30 });
+    if (i == pool->capacity) {
+        pool->capacity = pool->bounds.capacity;
+        pool->state = realloc(pool->state, pool->capacity * sizeof(uint8_t));
+        pool->style = realloc(pool->style, pool->capacity * sizeof(rui_button_style));
+    }
+    pool->state[i] = 0;
+    pool->style[i] = (rui_button_style){ text, 10, COLOR_BLUE, COLOR_SKYBLUE, COLOR_DARKBLUE, COLOR_WHITE };
+    damage_rect(rect_array_get(&pool->bounds, i));
+    return i;
+}
+
+void set_button_bounds(rui_context *ctx, int button, Rectangle bounds) {
+    damage_rect(rect_array_get(&ctx->buttons.bounds, button));
+    rect_array_set(&ctx->buttons.bounds, button, bounds);
+    damage_rect(bounds);
+}
+
+// Whether the button was clicked in the last update_context
+bool button_clicked(const rui_context *ctx, int button) {
+    return ctx->buttons.state[button] & RUI_WIDGET_CLICKED;
+}
+
+// Circle and label of a context radio button, as get_radio_button_area
+static Rectangle rui_radio_area(const rui_radio_pool *pool, int i) {
+    Rectangle circle = rect_array_get(&pool->bounds, i);
+    float right = (int)circle.x + (int)circle.width / 2 + circle.width + pool->style[i].label_width;
+    return (Rectangle){ circle.x, circle.y, right - circle.x, circle.height > 10 ? circle.height : 10 };
+}
+
+// Add a radio button centered on (x, y) to a group; returns its index
+int add_radio_button(rui_context *ctx, int x, int y, int width, int height, const char *label, int group) {
+    rui_radio_pool *pool = &ctx->radios;
+    int i = rect_array_add(&pool->bounds, (Rectangle){ x - width / 2, y - height / 2, width, height });
+    if (i == pool->capacity) {
+        pool->capacity = pool->bounds.capacity;
+        pool->state = realloc(pool->state, pool->capacity * sizeof(uint8_t));
+        pool->group = realloc(pool->group, pool->capacity * sizeof(int));
+        pool->style = realloc(pool->style, pool->capacity * sizeof(rui_radio_style));
+    }
+    pool->state[i] = 0;
+    pool->group[i] = group;
+    pool->style[i] = (rui_radio_style){ label, measure_text(label, 10) };
+    damage_rect(rui_radio_area(pool, i));
+    return i;
+}
+
+bool radio_button_selected(const rui_context *ctx, int radio) {
+    return ctx->radios.state[radio] & RUI_WIDGET_SELECTED;
+}
+
+// Selected radio button of a group, or -1
+int selected_radio_button(const rui_context *ctx, int group) {
+    for (int i = 0; i < ctx->radios.bounds.count; i++) {
+        if (ctx->radios.group[i] == group && (ctx->radios.state[i] & RUI_WIDGET_SELECTED)) return i;
+    }
+    return -1;
+}
+
+static void rui_set_button_state(rui_button_pool *pool, int i, uint8_t state) {
+    uint8_t visible = RUI_WIDGET_HOVERED | RUI_WIDGET_PRESSED;
+    if ((pool->state[i] & visible) != (state & visible)) damage_rect(rect_array_get(&pool->bounds, i));
+    pool->state[i] = state;
+}
+
+static void rui_update_buttons(rui_button_pool *pool, const rui_input *input) {
+    if (pool->clicked >= 0) pool->state[pool->clicked] &= ~RUI_WIDGET_CLICKED;
+    pool->clicked = -1;
+    // Only the button under the pointer and the one that was can change
+    int hovered = rect_array_hit(&pool->bounds, input->mouse);
+    if (pool->hovered >= 0 && pool->hovered != hovered) rui_set_button_state(pool, pool->hovered, 0);
+    if (hovered >= 0) {
+        uint8_t state = RUI_WIDGET_HOVERED;
+        if (input->mouse_down[MOUSE_LEFT_BUTTON]) {
+            state |= RUI_WIDGET_PRESSED;
+        } else if (input->mouse_released[MOUSE_LEFT_BUTTON]) {
+            state |= RUI_WIDGET_CLICKED;
+            pool->clicked = hovered;
+        }
+        rui_set_button_state(pool, hovered, state);
+    }
+    pool->hovered = hovered;
+}
+
+static void rui_update_radios(rui_radio_pool *pool, const rui_input *input) {
+    if (!input->mouse_pressed[MOUSE_LEFT_BUTTON]) return;
+    int hit = rect_array_hit(&pool->bounds, input->mouse);
+    if (hit < 0) return;
+    if (pool->state[hit] & RUI_WIDGET_SELECTED) {
+        // Deselect if the currently selected option is clicked again
+        pool->state[hit] &= ~RUI_WIDGET_SELECTED;
+        damage_rect(rui_radio_area(pool, hit));
+        return;
+    }
+    for (int i = 0; i < pool->bounds.count; i++) {
+        if (pool->group[i] == pool->group[hit] && (pool->state[i] & RUI_WIDGET_SELECTED)) {
+            pool->state[i] &= ~RUI_WIDGET_SELECTED;
+            damage_rect(rui_radio_area(pool, i));
+        }
+    }
+    pool->state[hit] |= RUI_WIDGET_SELECTED;
+    damage_rect(rui_radio_area(pool, hit));
+}
+
+// Update every widget of the context from this frame's input
+void update_context(rui_context *ctx, const rui_input *input) {
+    rui_update_buttons(&ctx->buttons, input);
+    rui_update_radios(&ctx->radios, input);
+}
+
+// Draw the widgets of the context that overlap the frame's damage
+void render_context(rui_context *ctx) {
+    if (!has_damage()) return;
+    const rui_button_pool *buttons = &ctx->buttons;
+    for (int i = 0; i < buttons->bounds.count; i++) {
+        Rectangle bounds = rect_array_get(&buttons->bounds, i);
+        if (!is_damaged(bounds)) continue;
+        const rui_button_style *style = &buttons->style[i];
+        RUI_COLOR color = style->color;
+        if (buttons->state[i] & RUI_WIDGET_HOVERED) color = style->hover_color;
+        if (buttons->state[i] & RUI_WIDGET_PRESSED) color = style->clicked_color;
+        rui_draw_button(bounds, style->text, style->font_size, color, style->text_color);
+    }
+    const rui_radio_pool *radios = &ctx->radios;
+    for (int i = 0; i < radios->bounds.count; i++) {
+        if (!is_damaged(rui_radio_area(radios, i))) continue;
+        Rectangle circle = rect_array_get(&radios->bounds, i);
+        int width = circle.width, height = circle.height;
+        rui_draw_radio_button((int)circle.x + width / 2, (int)circle.y + height / 2, width, height,
+                              radios->style[i].label, radios->state[i] & RUI_WIDGET_SELECTED);
+    }
+}
+
+//--------------------------- Keyboard Focus ---------------------------
+// The context decides which text widget gets the keyboard. Text boxes and
+// entries added with add_focus_* form a chain in Tab order; a click on one of
+// them, or Tab and Shift+Tab, moves the focus along it. update_focus then
+// runs only the focused widget, so a frame's typing costs the same with one
+// text widget or a thousand, and no two widgets see the same characters. The
+// others keep their active flag cleared and are not updated at all, so they
+// must not also be passed to update_text_box/update_text_entry.
+//
+// Text children of a MenuWindow join the chain with add_focus_child; their
+// window then leaves them alone, and update_focus runs the focused one with
+// the input and drawing translated by the window's position. A click reaches
+// such a child through its window, so windows must be updated (with
+// update_window_manager or update_menu_window_children) before update_focus.
+//
+// An immediate-mode rui_text_field that takes the focus takes it from the
+// chain as well, and focusing a widget of the chain takes it from the field.
+
+static int rui_focus_add(rui_context *ctx, rui_focus_kind kind, void *widget, MenuWindow *window) {
+    if (ctx->focus_count == ctx->focus_capacity) {
+        ctx->focus_capacity = ctx->focus_capacity ? ctx->focus_capacity * 2 : 8;
+        ctx->focus_chain = realloc(ctx->focus_chain, ctx->focus_capacity * sizeof(rui_focus_entry));
+    }
+    ctx->focus_chain[ctx->focus_count] = (rui_focus_entry){ kind, widget, window };
+    return ctx->focus_count++;
+}
+
+// Add a text box at the end of the Tab order; returns its index in the chain
+int add_focus_text_box(rui_context *ctx, TextBox *text_box) {
+    text_box->active = false;
+    return rui_focus_add(ctx, RUI_FOCUS_TEXT_BOX, text_box, NULL);
+}
+
+int add_focus_text_entry(rui_context *ctx, TextEntry *entry) {
+    entry->active = false;
+    return rui_focus_add(ctx, RUI_FOCUS_TEXT_ENTRY, entry, NULL);
+}
+
+// Add a text box or text entry child of a window, see add_child_text_box;
+// returns its index in the chain, or -1 if the child is another kind of node
+int add_focus_child(rui_context *ctx, MenuWindow *window, int child) {
+    rui_layout_node *node = &window->children[child];
+    rui_focus_kind kind;
+    if (node->type == RUI_CHILD_TEXT_BOX) {
+        kind = RUI_FOCUS_TEXT_BOX;
+        ((TextBox *)node->widget)->active = false;
+    } else if (node->type == RUI_CHILD_TEXT_ENTRY) {
+        kind = RUI_FOCUS_TEXT_ENTRY;
+        ((TextEntry *)node->widget)->active = false;
+    } else {
+        return -1;
+    }
+    node->focus_chained = true;
+    return rui_focus_add(ctx, kind, node->widget, window);
+}
+
+// Screen bounds of a widget of the chain
+static Rectangle rui_focus_bounds(const rui_focus_entry *focus) {
+    Rectangle bounds = focus->kind == RUI_FOCUS_TEXT_BOX ? toRaylibRectangle(((TextBox *)focus->widget)->textbox_bounds)
+                                                         : toRaylibRectangle(((TextEntry *)focus->widget)->textentry_bounds);
+    if (focus->window) {
+        bounds.x += focus->window->bounds.x;
+        bounds.y += focus->window->bounds.y;
+    }
+    return bounds;
+}
+
+static bool rui_focus_hit(const rui_focus_entry *focus, Vector2 point) {
+    if (focus->window) return focus->window->focus_pressed == focus->widget;
+    const rui_hit *hit = focus->kind == RUI_FOCUS_TEXT_BOX ? &((TextBox *)focus->widget)->hit : &((TextEntry *)focus->widget)->hit;
+    return rui_hit_test(hit, point, rui_focus_bounds(focus));
+}
+
+// Turn a widget's cursor on or off, damaging it
+static void rui_focus_activate(rui_focus_entry *focus, bool active) {
+    Rectangle bounds = rui_focus_bounds(focus);
+    if (focus->kind == RUI_FOCUS_TEXT_BOX) {
+        TextBox *text_box = focus->widget;
+        text_box->active = active;
+        text_box->cursor_visible = false;
+        damage_rect(bounds);
+    } else {
+        TextEntry *entry = focus->widget;
+        entry->active = active;
+        entry->cursor_visible = false;
+        damage_rect(bounds);
+    }
+}
+
+// Give the keyboard to widget `index` of the chain, or to none with -1
+void set_focus(rui_context *ctx, int index) {
+    if (index < -1 || index >= ctx->focus_count) index = -1;
+    if (index >= 0) ctx->focus = 0;
+    if (index == ctx->focused) return;
+    if (ctx->focused >= 0) rui_focus_activate(&ctx->focus_chain[ctx->focused], false);
+    ctx->focused = index;
+    if (index >= 0) rui_focus_activate(&ctx->focus_chain[index], true);
+}
+
+// Index of the focused widget of the chain, or -1
+int get_focus(const rui_context *ctx) {
+    return ctx->focused;
+}
+
+// Take a widget out of the chain, e.g. before destroying it
+void remove_focus_widget(rui_context *ctx, void *widget) {
+    for (int i = 0; i < ctx->focus_count; i++) {
+        if (ctx->focus_chain[i].widget != widget) continue;
+        if (ctx->focused == i) set_focus(ctx, -1);
+        MenuWindow *window = ctx->focus_chain[i].window;
+        for (int c = 1; window && c < window->child_count; c++) {
+            // Its window updates it again
+            if (window->children[c].widget == widget) window->children[c].focus_chained = false;
+        }
+        memmove(&ctx->focus_chain[i], &ctx->focus_chain[i + 1], (ctx->focus_count - i - 1) * sizeof(rui_focus_entry));
+        ctx->focus_count--;
+        if (ctx->focused > i) ctx->focused--;
+        return;
+    }
+}
+
+// Move the focus for clicks and Tab, then update the focused widget
+void update_focus(rui_context *ctx, const rui_input *input) {
+    if (input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
+        int clicked = -1;
+        for (int i = ctx->focus_count - 1; i >= 0 && clicked < 0; i--) {
+            if (rui_focus_hit(&ctx->focus_chain[i], input->mouse)) clicked = i;
+        }
+        set_focus(ctx, clicked);
+    }
+    if (ctx->focused < 0 && ctx->focus != 0) return;  // an immediate-mode field has the keys
+
+    rui_input keys = *input;
+    bool tab = false;
+    keys.key_count = 0;
+    for (int i = 0; i < input->key_count; i++) {
+        if (input->keys[i] == KEY_TAB) tab = true;
+        else keys.keys[keys.key_count++] = input->keys[i];
+    }
+    keys.event_count = 0;
+    for (int i = 0; i < input->event_count; i++) {
+        if (input->events[i].code != KEY_TAB || input->events[i].type == RUI_KEY_CHAR) keys.events[keys.event_count++] = input->events[i];
+    }
+    if (tab && ctx->focus_count > 0) {
+        int step = input->shift ? ctx->focus_count - 1 : 1;
+        if (ctx->focused < 0) set_focus(ctx, input->shift ? ctx->focus_count - 1 : 0);
+        else set_focus(ctx, (ctx->focused + step) % ctx->focus_count);
+    }
+    if (ctx->focused < 0) return;
+
+    rui_focus_entry *focus = &ctx->focus_chain[ctx->focused];
+    if (focus->window) {
+        // As update_menu_window_children would
+        keys.mouse.x -= focus->window->bounds.x;
+        keys.mouse.y -= focus->window->bounds.y;
+        begin_translate(focus->window->bounds.x, focus->window->bounds.y);
+    }
+    if (focus->kind == RUI_FOCUS_TEXT_BOX) update_text_box(focus->widget, &keys);
+    else update_text_entry(focus->widget, &keys);
+    if (focus->window) end_translate();
+}
+
+//--------------------------- Immediate Mode ---------------------------
+// Widgets that exist only for the frame they are called in:
+//
+//     rui_begin(&ctx, &input);
+//     begin_drawing();
+//     clear_background(COLOR_RAYWHITE);
+//     if (rui_button(&ctx, "Save", (Rectangle){ 20, 20, 70, 30 })) save();
+//     rui_end(&ctx);
+//     end_drawing();
+//
+// A widget is identified by its label hashed with the IDs pushed around it
+// (rui_push_id, rui_push_index), so two "Delete" buttons in different rows
+// must sit under different IDs. The little state that has to outlive a frame,
+// a text cursor or a scroll offset, is kept in a hash table in the context
+// under that ID, and entries of widgets that are not drawn for
+// RUI_STATE_MAX_AGE frames are dropped. The table also remembers where each
+// widget was and a hash of what it looked like, which is how the damage of a
+// widget that changed, moved or went away is found. Immediate-mode widgets
+// record their draw commands every frame, since that damage may only be found
+// after a widget below was drawn; end_drawing() replays only the commands
+// touching the damage.
+
+static uint32_t rui_hash(const void *data, int size, uint32_t seed) {
+    const uint8_t *bytes = data;
+    uint32_t hash = seed ^ 2166136261u;  // FNV-1a
+    for (int i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t rui_id_seed(const rui_context *ctx) {
+    int depth = ctx->id_depth < RUI_ID_STACK_DEPTH ? ctx->id_depth : RUI_ID_STACK_DEPTH;
+    return depth > 0 ? ctx->id_stack[depth - 1] : 0;
+}
+
+static uint32_t rui_make_id(const rui_context *ctx, const void *data, int size) {
+    uint32_t id = rui_hash(data, size, rui_id_seed(ctx));
+    return id ? id : 1;  // 0 is an empty slot
+}
+
+static void rui_push(rui_context *ctx, uint32_t id) {
+    if (ctx->id_depth == RUI_ID_STACK_DEPTH) TraceLog(LOG_WARNING, "RUI: ID stack full, deeper IDs are not unique");
+    if (ctx->id_depth < RUI_ID_STACK_DEPTH) ctx->id_stack[ctx->id_depth] = id;
+    ctx->id_depth++;
+}
+
+// Scope the IDs of the following widgets, until rui_pop_id
+void rui_push_id(rui_context *ctx, const char *id) {
+    rui_push(ctx, rui_make_id(ctx, id, strlen(id)));
+}
+
+// rui_push_id for generated rows, e.g. the index of an item
+void rui_push_index(rui_context *ctx, int index) {
+    rui_push(ctx, rui_make_id(ctx, &index, sizeof(index)));
+}
+
+void rui_pop_id(rui_context *ctx) {
+    if (ctx->id_depth > 0) ctx->id_depth--;
+}
+
+// Copy the live entries to a table of `capacity` slots, dropping the stale ones
+static void rui_state_rehash(rui_context *ctx, int capacity) {
+    rui_state_entry *old = ctx->states;
+    int old_capacity = ctx->state_capacity;
+    ctx->states = calloc(capacity, sizeof(rui_state_entry));
+    ctx->state_capacity = capacity;
+    ctx->state_count = 0;
+    for (int i = 0; i < old_capacity; i++) {
+        if (!old[i].id || ctx->frame - old[i].last_frame > RUI_STATE_MAX_AGE) continue;
+        int slot = old[i].id & (capacity - 1);
+        while (ctx->states[slot].id) slot = (slot + 1) & (capacity - 1);
+        ctx->states[slot] = old[i];
+        ctx->state_count++;
+    }
+    free(old);
+}
+
+// Entry of a widget, created empty the first time it is drawn
+static rui_state_entry *rui_state_get(rui_context *ctx, uint32_t id) {
+    if ((ctx->state_count + 1) * 2 > ctx->state_capacity) {
+        rui_state_rehash(ctx, ctx->state_capacity ? ctx->state_capacity * 2 : 64);
+    }
+    int mask = ctx->state_capacity - 1;
+    int slot = id & mask;
+    while (ctx->states[slot].id && ctx->states[slot].id != id) slot = (slot + 1) & mask;
+    rui_state_entry *entry = &ctx->states[slot];
+    if (!entry->id) {
+        *entry = (rui_state_entry){0};
+        entry->id = id;
+        ctx->state_count++;
+    }
+    return entry;
+}
+
+// Mark a widget as drawn this frame at `bounds`
+static void rui_state_place(rui_context *ctx, rui_state_entry *entry, Rectangle bounds) {
+    if (memcmp(&entry->bounds, &bounds, sizeof(bounds)) != 0) {
+        damage_rect(entry->bounds);
+        damage_rect(bounds);
+        entry->bounds = bounds;
+    }
+    entry->last_frame = ctx->frame;
+}
+
+// Damage a widget when what it draws changed since the last frame
+static void rui_state_look(rui_state_entry *entry, uint32_t look) {
+    if (entry->look == look) return;
+    damage_rect(entry->bounds);
+    entry->look = look;
+}
+
+static bool rui_imm_inside(const rui_context *ctx, Rectangle bounds) {
+    Vector2 mouse = ctx->input->mouse;
+    if (ctx->clip_depth > 0 && !CheckCollisionPointRec(mouse, ctx->clip)) return false;
+    return CheckCollisionPointRec(mouse, bounds);
+}
+
+// Place a widget and tell whether it is under the pointer. Widgets drawn later
+// are on top, but that is only known at the end of the frame, so a widget
+// yields to the one that was on top in the last frame while the pointer is
+// still over that one.
+static rui_state_entry *rui_imm_widget(rui_context *ctx, uint32_t id, Rectangle bounds, bool *hovered) {
+    rui_state_entry *entry = rui_state_get(ctx, id);
+    rui_state_place(ctx, entry, bounds);
+    bool inside = rui_imm_inside(ctx, bounds);
+    if (inside) {
+        ctx->next_hot = id;
+        ctx->next_hot_bounds = bounds;
+    }
+    *hovered = inside && (ctx->hot == id || !CheckCollisionPointRec(ctx->input->mouse, ctx->hot_bounds));
+    if (*hovered) {
+        ctx->hot = id;
+        ctx->hot_bounds = bounds;
+    }
+    return entry;
+}
+
+// Start a frame of immediate-mode widgets; `input` must stay valid until rui_end.
+// Frees what the last frame allocated from ctx->arena.
+void rui_begin(rui_context *ctx, const rui_input *input) {
+    ctx->input = input;
+    ctx->frame++;
+    ctx->id_depth = 0;
+    ctx->clip_depth = 0;
+    ctx->hot = ctx->next_hot;
+    ctx->hot_bounds = ctx->next_hot_bounds;
+    ctx->next_hot = 0;
+    ctx->next_hot_bounds = (Rectangle){0};
+    arena_reset(&ctx->arena);
+}
+
+// Finish the frame: damage the widgets that were not drawn, and drop the
+// state of those unused for RUI_STATE_MAX_AGE frames. Call it before end_drawing.
+void rui_end(rui_context *ctx) {
+    if (!ctx->input->mouse_down[MOUSE_LEFT_BUTTON]) ctx->active = 0;
+    if (ctx->id_depth != 0) TraceLog(LOG_WARNING, "RUI: %d IDs pushed and not popped", ctx->id_depth);
+    int stale = 0;
+    for (int i = 0; i < ctx->state_capacity; i++) {
+        const rui_state_entry *entry = &ctx->states[i];
+        if (!entry->id) continue;
+        uint32_t age = ctx->frame - entry->last_frame;
+        if (age == 1) damage_rect(entry->bounds);  // gone this frame
+        if (age > RUI_STATE_MAX_AGE) stale++;
+    }
+    if (stale) rui_state_rehash(ctx, ctx->state_capacity);
+}
+
+// Button with `label` as its text and ID; returns true when clicked
+bool rui_button(rui_context *ctx, const char *label, Rectangle bounds) {
+    const rui_input *input = ctx->input;
+    uint32_t id = rui_make_id(ctx, label, strlen(label));
+    bool hovered;
+    rui_state_entry *entry = rui_imm_widget(ctx, id, bounds, &hovered);
+    if (hovered && input->mouse_pressed[MOUSE_LEFT_BUTTON]) ctx->active = id;
+    bool pressed = hovered && ctx->active == id && input->mouse_down[MOUSE_LEFT_BUTTON];
+    bool clicked = hovered && ctx->active == id && input->mouse_released[MOUSE_LEFT_BUTTON];
+
+    rui_state_look(entry, (hovered ? RUI_WIDGET_HOVERED : 0) | (pressed ? RUI_WIDGET_PRESSED : 0));
+    RUI_COLOR color = pressed ? COLOR_DARKBLUE : hovered ? COLOR_SKYBLUE : COLOR_BLUE;
+    rui_draw_button(bounds, label, 10, color, COLOR_WHITE);
+    return clicked;
+}
+
+// Horizontal slider; returns true when it changed `value`
+bool rui_slider(rui_context *ctx, const char *id_text, Rectangle bounds, float *value, float min, float max) {
+    const rui_input *input = ctx->input;
+    uint32_t id = rui_make_id(ctx, id_text, strlen(id_text));
+    bool hovered;
+    rui_state_entry *entry = rui_imm_widget(ctx, id, bounds, &hovered);
+
+    float knob_width = bounds.height / 2;
+    float travel = bounds.width - knob_width;
+    float t = max > min ? (*value - min) / (max - min) : 0;
+    float knob_x = bounds.x + travel * (t < 0 ? 0 : t > 1 ? 1 : t);
+    if (hovered && input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
+        ctx->active = id;
+        // Grabbing the knob keeps it where it was grabbed, clicking the track centers it on the pointer
+        float grab = input->mouse.x - knob_x;
+        ctx->drag_offset = grab >= 0 && grab <= knob_width ? grab : knob_width / 2;
+    }
+    bool changed = false;
+    if (ctx->active == id && input->mouse_down[MOUSE_LEFT_BUTTON] && travel > 0) {
+        t = (input->mouse.x - ctx->drag_offset - bounds.x) / travel;
+        t = t < 0 ? 0 : t > 1 ? 1 : t;
+        float new_value = min + t * (max - min);
+        changed = new_value != *value;
+        *value = new_value;
+        knob_x = bounds.x + travel * t;
+    }
+
+    bool dragging = ctx->active == id;
+    rui_state_look(entry, rui_hash(&knob_x, sizeof(knob_x), (hovered ? RUI_WIDGET_HOVERED : 0) | (dragging ? RUI_WIDGET_PRESSED : 0)));
+    draw_rectangle(bounds.x, bounds.y + bounds.height / 2 - 2, bounds.width, 4, COLOR_LIGHTGRAY);
+    RUI_COLOR color = dragging ? COLOR_DARKBLUE : hovered ? COLOR_SKYBLUE : COLOR_BLUE;
+    draw_rectangle_rounded((Rectangle){ knob_x, bounds.y, knob_width, bounds.height }, 0.3f, 6, color);
+    return changed;
+}
+
+// Start of the UTF-8 codepoint before or after a byte offset of a field's text
+static int rui_field_previous(const char *text, int position) {
+    if (position > 0) position--;
+    while (position > 0 && ((unsigned char)text[position] & 0xC0) == 0x80) position--;
+    return position;
+}
+
+static int rui_field_next(const char *text, int length, int position) {
+    if (position < length) position++;
+    while (position < length && ((unsigned char)text[position] & 0xC0) == 0x80) position++;
+    return position;
+}
+
+// Width of the codepoint at a byte offset; its length in bytes goes to *size
+static float rui_field_advance(const char *text, int position, int font_size, int *size) {
+    return measure_glyph(GetCodepointNext(text + position, size), font_size);
+}
+
+// Single-line field editing the NUL-terminated `text` in place, of at most
+// `size` bytes with the terminator. The cursor and horizontal scroll are
+// kept in the state table. Returns true when the text changed.
+bool rui_text_field(rui_context *ctx, const char *id_text, Rectangle bounds, char *text, int size) {
+    const rui_input *input = ctx->input;
+    const int font_size = 10;
+    uint32_t id = rui_make_id(ctx, id_text, strlen(id_text));
+    bool hovered;
+    rui_state_entry *entry = rui_imm_widget(ctx, id, bounds, &hovered);
+    int length = strlen(text);
+    // The application may have changed the text since the last frame
+    if (entry->cursor > length) entry->cursor = length;
+    if (entry->offset > entry->cursor) entry->offset = entry->cursor;
+    if (entry->cursor < length && ((unsigned char)text[entry->cursor] & 0xC0) == 0x80) entry->cursor = rui_field_previous(text, entry->cursor);
+    if (entry->offset < length && ((unsigned char)text[entry->offset] & 0xC0) == 0x80) entry->offset = rui_field_previous(text, entry->offset);
+
+    float inner_width = bounds.width - 10;
+    if (input->mouse_pressed[MOUSE_LEFT_BUTTON]) {
+        if (hovered) {
+            set_focus(ctx, -1);
+            ctx->focus = id;
+            // Cursor on the character boundary closest to the click
+            float click_x = input->mouse.x - (bounds.x + 5);
+            float x = 0;
+            entry->cursor = entry->offset;
+            while (entry->cursor < length) {
+                int size;
+                float advance = rui_field_advance(text, entry->cursor, font_size, &size);
+                if (x + advance / 2 > click_x) break;
+                x += advance;
+                entry->cursor += size;
+            }
+        } else if (ctx->focus == id) {
+            ctx->focus = 0;
+        }
+    }
+
+    bool changed = false;
+    bool focused = ctx->focus == id;
+    if (focused) {
+        for (int i = 0; i < input->event_count; i++) {
+            const rui_key_event *event = &input->events[i];
+            int key = event->code;
+            if (event->type == RUI_KEY_CHAR) {
+                if (key < 32 || key > 125 || length + 1 >= size) continue;
+                memmove(text + entry->cursor + 1, text + entry->cursor, length - entry->cursor + 1);
+                text[entry->cursor++] = (char)key;
+                length++;
+                changed = true;
+            } else if (event->type == RUI_KEY_UP) {
+                continue;
+            } else if (key == KEY_BACKSPACE && entry->cursor > 0) {
+                int previous = rui_field_previous(text, entry->cursor);
+                memmove(text + previous, text + entry->cursor, length - entry->cursor + 1);
+                length -= entry->cursor - previous;
+                entry->cursor = previous;
+                changed = true;
+            } else if (key == KEY_DELETE && entry->cursor < length) {
+                int next = rui_field_next(text, length, entry->cursor);
+                memmove(text + entry->cursor, text + next, length - next + 1);
+                length -= next - entry->cursor;
+                changed = true;
+            } else if (key == KEY_LEFT) {
+                entry->cursor = rui_field_previous(text, entry->cursor);
+            } else if (key == KEY_RIGHT) {
+                entry->cursor = rui_field_next(text, length, entry->cursor);
+            } else if (key == KEY_HOME) {
+                entry->cursor = 0;
+            } else if (key == KEY_END) {
+                entry->cursor = length;
+            }
+        }
+        rui_request_blink_frame(input);
+    }
+
+    // Scroll horizontally to keep the cursor in view
+    if (entry->cursor < entry->offset) entry->offset = entry->cursor;
+    while (entry->offset < entry->cursor && measure_text_advance(text + entry->offset, entry->cursor - entry->offset, font_size) > inner_width) {
+        entry->offset = rui_field_next(text, length, entry->offset);
+    }
+    int visible_end = entry->offset;
+    float visible_width = 0;
+    while (visible_end < length) {
+        int size;
+        float advance = rui_field_advance(text, visible_end, font_size, &size);
+        if (visible_width + advance > inner_width) break;
+        visible_width += advance;
+        visible_end += size;
+    }
+
+    bool cursor_visible = focused && rui_cursor_blink_on(input);
+    uint32_t look = rui_hash(text, length, ((uint32_t)entry->cursor << 16) ^ entry->offset);
+    rui_state_look(entry, look ^ (cursor_visible ? 0x80000000u : 0) ^ (focused ? 0x40000000u : 0));
+
+    draw_rectangle_from_rect(bounds, COLOR_WHITE);
+    draw_rectangle_lines(bounds.x, bounds.y, bounds.width, bounds.height, COLOR_DARKGRAY);
+    int text_y = bounds.y + (bounds.height - font_size) / 2;
+    draw_text_n(text + entry->offset, visible_end - entry->offset, bounds.x + 5, text_y, font_size, COLOR_BLACK);
+    if (cursor_visible) {
+        float cursor_x = bounds.x + 5 + measure_text_advance(text + entry->offset, entry->cursor - entry->offset, font_size);
+        draw_rectangle(cursor_x, text_y, 2, font_size, COLOR_BLACK);
+    }
+    return changed;
+}
+
+// Start a vertically scrolling area showing `content_height` pixels of
+// widgets; returns the scroll offset to subtract from their y. The widgets
+// are clipped to the area and their IDs are scoped by it. Areas may nest.
+float rui_begin_scroll(rui_context *ctx, const char *id_text, Rectangle area, float content_height) {
+    const rui_input *input = ctx->input;
+    uint32_t id = rui_make_id(ctx, id_text, strlen(id_text));
+    rui_state_entry *entry = rui_state_get(ctx, id);
+    rui_state_place(ctx, entry, area);
+
+    float scroll = entry->scroll;
+    if (input->wheel != 0 && rui_imm_inside(ctx, area)) scroll -= input->wheel * 20;
+    float max_scroll = content_height - area.height;
+    if (scroll > max_scroll) scroll = max_scroll;
+    if (scroll < 0) scroll = 0;
+    if (scroll != entry->scroll) {
+        // Everything inside moves
+        damage_rect(area);
+        entry->scroll = scroll;
+    }
+
+    begin_scissor(area.x, area.y, area.width, area.height);
+    if (ctx->clip_depth < RUI_ID_STACK_DEPTH) ctx->clips[ctx->clip_depth] = ctx->clip;
+    if (ctx->clip_depth > 0) {
+        // Only the part inside the enclosing areas can be hovered
+        ctx->clip = rect_intersect(area, ctx->clip);
+    } else {
+        ctx->clip = area;
+    }
+    ctx->clip_depth++;
+    rui_push(ctx, id);
+    return scroll;
+}
+
+void rui_end_scroll(rui_context *ctx) {
+    rui_pop_id(ctx);
+    if (ctx->clip_depth > 0) ctx->clip_depth--;
+    if (ctx->clip_depth < RUI_ID_STACK_DEPTH) ctx->clip = ctx->clips[ctx->clip_depth];
+    end_scissor();
+}
+
+//--------------------------- General UI Functions ---------------------------
+
+void init_ui(char *title, int w, int h) {
+    init(title, w, h);
+    const char *record = getenv("RUI_RECORD_INPUT");
+    const char *replay = getenv("RUI_REPLAY_INPUT");
+    const char *realtime = getenv("RUI_REPLAY_REALTIME");
+    if (record) record_input(record);
+    if (replay) replay_input(replay, realtime && atoi(realtime) != 0);
+}
+
+// True when the window is closed, or once a replayed input log has run out
+bool ui_should_close() {
+    return WindowShouldClose() || rui_input_log.finished;
 }
 
 void quit_ui() {
+    stop_input_log();
     quit();
 }